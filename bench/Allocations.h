@@ -0,0 +1,10 @@
+#ifndef CGT_ALLOCATIONS_H
+#define CGT_ALLOCATIONS_H
+
+#include <cstddef>
+
+//Number of calls to the global operator new so far, replaced in Allocations.cpp. The replacements live in their own
+//translation unit so that they are never inlined into a caller, which would pair the malloc of one with the free of another
+std::size_t allocationCount();
+
+#endif
@@ -0,0 +1,736 @@
+//Headless microbenchmarks of the ECS core. Prints ns/op and heap allocations/op for each benchmark and scale
+#include "World.h"
+#include "Entity.h"
+#include "Component.h"
+#include "Snapshot.hpp"
+#include "Prefab.hpp"
+#include "EntityPool.h"
+#include "StateStream.h"
+#include "Rotator.h"
+#include "Allocations.h"
+#include <chrono>
+#include <vector>
+#include <string_view>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <memory_resource>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    class Payload : public Component
+    {
+    public:
+        struct Snapshot
+        {
+            float value;
+        };
+
+        Payload(const EntityKey& key, float v = 0) : Component(key), value(v) {}
+        Payload(const EntityKey& key, const Snapshot& s) : Component(key), value(s.value) {}
+        Snapshot snapshot(const SnapshotWriter&) const { return { value }; }
+        void add(float v) { value += v; }
+        float value;
+    };
+
+    class SparsePayload : public Payload
+    {
+    public:
+        static constexpr ComponentStorage storage = ComponentStorage::Sparse;
+        using Payload::Payload;
+    };
+
+    //Sized like a typical component, so that visiting them in a random order misses the cache
+    template<ComponentStorage Storage>
+    class Located : public Component
+    {
+    public:
+        static constexpr ComponentStorage storage = Storage;
+
+        Located(const EntityKey& key, glm::vec3 p = {}) : Component(key), position(p) {}
+        glm::vec3 spatialPosition() const { return position; }
+        glm::vec3 position;
+        float payload[24] = {};
+    };
+
+    class Other : public Component
+    {
+    public:
+        Other(const EntityKey& key) : Component(key) {}
+    };
+
+    class Dependent : public DependentComponent<Payload>
+    {
+    public:
+        Dependent(const EntityKey& key) : DependentComponent(key) {}
+    };
+
+    class Tracked : public Component, public ChangeTracked
+    {
+    public:
+        Tracked(const EntityKey& key) : Component(key) {}
+        void touch() { markChanged(world()); }
+    };
+
+    //Same update, run in a single chunk or split across the WorkerPool
+    template<bool Parallel>
+    class Integrator : public Component
+    {
+    public:
+        static constexpr bool parallel = Parallel;
+
+        Integrator(const EntityKey& key) : Component(key) {}
+        void update(Seconds delta)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                velocity += (0.5f - position) * delta.count();
+                position += velocity * delta.count();
+            }
+        }
+        float position = 0;
+        float velocity = 1;
+    };
+
+    //Same update, skipped on the entities in a higher update bucket
+    class ThrottledIntegrator : public Integrator<false>, public Throttled
+    {
+    public:
+        using Integrator::Integrator;
+    };
+
+    using BenchComponents = ComponentList<Payload, SparsePayload, Other, Dependent, Tracked, Integrator<false>, Integrator<true>,
+        ThrottledIntegrator, Located<ComponentStorage::OwnerSorted>, Located<ComponentStorage::Spatial>>;
+
+    //Time and heap allocations from construction to stop, divided by the number of operations done in between
+    class Measure
+    {
+    public:
+        explicit Measure(std::string_view name, std::size_t scale)
+            : _name(name), _scale(scale), _allocations(allocationCount()), _start(Clock::now())
+        {
+        }
+
+        void stop(std::size_t ops)
+        {
+            auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - _start).count();
+            std::size_t allocations = allocationCount() - _allocations;
+            std::printf("%-24.*s %9zu %12.2f %12.3f\n", static_cast<int>(_name.size()), _name.data(), _scale, elapsed / ops, static_cast<double>(allocations) / ops);
+        }
+
+    private:
+        std::string_view _name;
+        std::size_t _scale;
+        std::size_t _allocations;
+        Clock::time_point _start;
+    };
+
+    //Keeps the optimizer from dropping the benchmarked work
+    volatile float sink;
+
+    //The benchmarks double as smoke tests of the features they time, a wrong result stops the run
+    void check(bool ok, const char* what)
+    {
+        if (ok) return;
+        std::fprintf(stderr, "check failed: %s\n", what);
+        std::exit(1);
+    }
+
+    std::vector<Entity*> createEntities(World& world, std::size_t n)
+    {
+        std::vector<Entity*> entities;
+        entities.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) entities.push_back(&world.createEntity());
+        return entities;
+    }
+
+    void benchCreateEntity(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        Measure m("createEntity", n);
+        for (std::size_t i = 0; i < n; ++i) world.createEntity();
+        m.stop(n);
+    }
+
+    void benchBuildComponent(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        auto entities = createEntities(world, n);
+        {
+            Measure m("buildComponent", n);
+            for (Entity* e : entities) e->buildComponent<Payload>(1.f);
+            m.stop(n);
+        }
+        {
+            Measure m("buildComponent+deps", n);
+            for (Entity* e : entities) e->buildComponent<Dependent>();
+            m.stop(n);
+        }
+        Measure m("cleanup new", n);
+        world.update(Seconds{});
+        m.stop(2 * n);
+    }
+
+    //The same entities built by hand then from a prefab
+    void benchInstantiate(std::size_t n)
+    {
+        {
+            World world{ BenchComponents{} };
+            Measure m("build by hand", n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                Entity& e = world.createEntity();
+                e.buildComponent<Payload>(static_cast<float>(i));
+                e.buildComponent<Dependent>();
+            }
+            m.stop(n);
+        }
+        World world{ BenchComponents{} };
+        Prefab prefab;
+        prefab.add<Payload>(1.f);
+        prefab.add<Dependent>();
+        {
+            Measure m("instantiate", n);
+            world.instantiate(prefab, n, [](Entity& e, std::size_t i) { e.findComponent<Payload>()->value = static_cast<float>(i); });
+            m.stop(n);
+        }
+        Measure m("instantiate cleanup", n);
+        world.update(Seconds{});
+        m.stop(2 * n);
+    }
+
+    void benchFindComponent(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        auto entities = createEntities(world, n);
+        for (Entity* e : entities)
+        {
+            e->buildComponent<Payload>();
+            e->buildComponent<Other>();
+        }
+        world.update(Seconds{});
+
+        float sum = 0;
+        Measure m("findComponent", n);
+        for (Entity* e : entities) sum += e->findComponent<Payload>()->value;
+        for (Entity* e : entities) sum += e->findComponent<Dependent>() != nullptr;
+        m.stop(2 * n);
+        sink = sum;
+    }
+
+    //Payload on every entity, Other on every other one, joined by a Query or by looking each one up
+    void benchQuery(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        auto entities = createEntities(world, n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            entities[i]->buildComponent<Payload>(static_cast<float>(i));
+            if (i % 2 == 0) entities[i]->buildComponent<Other>();
+        }
+        world.update(Seconds{});
+
+        double query_sum = 0; //Exact for these integer values, whatever the order
+        {
+            Measure m("query", n);
+            for (auto [p, o] : world.query<Payload, Other>()) query_sum += p.value;
+            m.stop(n);
+        }
+        double find_sum = 0;
+        {
+            Measure m("join findComponent", n);
+            for (Entity* e : entities) if (e->findComponent<Other>()) find_sum += e->findComponent<Payload>()->value;
+            m.stop(n);
+        }
+        sink = static_cast<float>(query_sum + find_sum);
+
+        std::size_t joined = 0;
+        for (auto [p, o] : world.query<Payload, Other>())
+        {
+            check(&p.owner() == &o.owner(), "query joins components of the same entity");
+            check(p.owner().findComponent<Payload>() == &p && p.owner().findComponent<Other>() == &o, "query matches findComponent");
+            ++joined;
+        }
+        check(joined == (n + 1) / 2, "query finds every entity owning both");
+        check(query_sum == find_sum, "query and findComponent sum the same values");
+
+        entities[0]->buildComponent<Payload>(-1.f);
+        world.update(Seconds{});
+        joined = 0;
+        for (auto [p, o] : world.query<Payload, Other>())
+        {
+            check(p.value >= 0, "query yields the first component of each type");
+            ++joined;
+        }
+        check(joined == (n + 1) / 2, "query yields an entity owning several components of the first type once");
+    }
+
+    void benchCleanup(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, 2 * n)) e->buildComponent<Payload>();
+        world.update(Seconds{});
+
+        for (std::size_t i = 0; i < n; ++i) world.view<Payload>()[2 * i].destroy();
+        Measure m("cleanup dead", n);
+        world.update(Seconds{});
+        m.stop(n);
+    }
+
+    //Spawns and destroys a few components per update among n long lived ones, like short lived projectiles
+    template<typename C>
+    void benchChurn(std::string_view name, std::size_t n)
+    {
+        constexpr std::size_t frames = 100;
+        constexpr std::size_t per_frame = 16;
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<C>();
+        world.update(Seconds{});
+
+        std::vector<Entity*> spawned;
+        auto churn = [&] {
+            for (Entity* e : spawned) e->destroy();
+            spawned = createEntities(world, per_frame);
+            for (Entity* e : spawned) e->buildComponent<C>();
+            world.update(Seconds{});
+        };
+        //Untimed, the first frames grow the storage and the HandleTable past the long lived components once
+        for (int frame = 0; frame < 4; ++frame) churn();
+        Measure m(name, n);
+        for (std::size_t frame = 0; frame < frames; ++frame) churn();
+        m.stop(frames * per_frame);
+    }
+
+    //Same churn, with the entities released to and acquired from a pool rather than destroyed and built
+    void benchPooledChurn(std::size_t n)
+    {
+        constexpr std::size_t frames = 100;
+        constexpr std::size_t per_frame = 16;
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<Payload>();
+        Prefab prefab;
+        prefab.add<Payload>();
+        EntityPool pool(world, prefab);
+        pool.reserve(per_frame);
+        world.update(Seconds{});
+
+        std::vector<Entity*> spawned;
+        auto churn = [&] {
+            for (std::size_t frame = 0; frame < frames; ++frame)
+            {
+                for (Entity* e : spawned) e->release();
+                spawned.clear();
+                for (std::size_t i = 0; i < per_frame; ++i) spawned.push_back(&pool.acquire([](Entity& e) { e.findComponent<Payload>()->value = 0; }));
+                world.update(Seconds{});
+            }
+        };
+        {
+            Measure m("churn pooled", n);
+            churn();
+            m.stop(frames * per_frame);
+        }
+
+        //A pool sized for bursts, here as many released entities as long lived ones, stays out of the passes over the others
+        pool.reserve(n);
+        world.update(Seconds{});
+        check(world.view<Payload>().size() == n + per_frame, "the components of released entities are out of view");
+        {
+            Measure m("churn pooled, large pool", n);
+            churn();
+            m.stop(frames * per_frame);
+        }
+        float sum = 0;
+        Measure m("view beside large pool", n);
+        for (const Payload& p : world.view<Payload>()) sum += p.value;
+        m.stop(n);
+        sink = sum;
+    }
+
+    //Visits the components cell by cell of a uniform grid, the access pattern of a broad phase or of batched draws
+    template<ComponentStorage Storage>
+    void benchSpatial(std::string_view name, std::size_t n)
+    {
+        using C = Located<Storage>;
+        World world{ BenchComponents{} };
+        std::srand(1);
+        auto coordinate = [] { return static_cast<float>(std::rand()) / RAND_MAX * 100.f; };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<C>(glm::vec3{ coordinate(), coordinate(), coordinate() });
+        world.spatialReorderPeriod(1);
+        world.update(Seconds{});
+
+        constexpr int cells = 16;
+        std::vector<std::vector<C*>> grid(cells * cells * cells);
+        for (C& c : world.view<C>())
+        {
+            auto cell = [&c](int axis) { return std::min(static_cast<int>(c.position[axis] / 100.f * cells), cells - 1); };
+            grid[(cell(2) * cells + cell(1)) * cells + cell(0)].push_back(&c);
+        }
+
+        float sum = 0;
+        Measure m(name, n);
+        for (auto& cell : grid)
+        {
+            for (C* c : cell) for (float f : c->payload) sum += f + c->position.x;
+        }
+        m.stop(n);
+        sink = sum;
+    }
+
+    //A short lived world, from construction to teardown, on the global heap or on an arena dropped at once
+    void benchWorldLifetime(std::string_view name, std::size_t n, bool arena)
+    {
+        Measure m(name, n);
+        std::pmr::monotonic_buffer_resource monotonic;
+        {
+            World world{ BenchComponents{}, arena ? &monotonic : std::pmr::get_default_resource() };
+            world.executionMode(ExecutionMode::Serial);
+            for (Entity* e : createEntities(world, n))
+            {
+                e->buildComponent<Payload>(1.f);
+                e->buildComponent<Dependent>();
+            }
+            world.update(Seconds{});
+        }
+        m.stop(n);
+    }
+
+    void benchGetAll(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<Payload>(1.f);
+        world.update(Seconds{});
+
+        {
+            float sum = 0;
+            Measure m("getAll", n);
+            for (Payload* p : world.getAll<Payload>()) sum += p->value;
+            m.stop(n);
+            sink = sum;
+        }
+        float sum = 0;
+        Measure m("view", n);
+        for (Payload& p : world.view<Payload>()) sum += p.value;
+        m.stop(n);
+        sink = sum;
+    }
+
+    //One component in a thousand changed since the version, found by changed or by checking all of them
+    void benchChanged(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<Tracked>();
+        world.update(Seconds{});
+        std::uint32_t since = world.changeVersion() - 1; //Changes made between updates share the current version
+        std::size_t touched = 0;
+        for (std::size_t i = 0; i < n; i += 1000, ++touched) world.view<Tracked>()[i].touch();
+
+        std::size_t found = 0;
+        constexpr int repeats = 16;
+        {
+            Measure m("changed", n);
+            for (int r = 0; r < repeats; ++r) found += std::ranges::distance(world.changed<Tracked>(since));
+            m.stop(repeats * n);
+        }
+        check(found == repeats * touched, "changed finds the changed components");
+        std::size_t scanned = 0;
+        {
+            Measure m("changed full pass", n);
+            for (int r = 0; r < repeats; ++r)
+            {
+                for (const Tracked& t : world.view<Tracked>()) scanned += t.changedSince(since);
+            }
+            m.stop(repeats * n);
+        }
+        check(scanned == found, "changed matches a full pass");
+    }
+
+    //Entity i sits at x = i and moves up by one before the frames f where (i + f) % 10 == 0, a tenth of them per frame
+    float streamHeight(std::size_t i, std::size_t frame)
+    {
+        std::size_t first = (10 - i % 10) % 10;
+        return first > frame ? 0.f : static_cast<float>((frame - first) / 10 + 1);
+    }
+
+    //Every replayed entity is where the recorded one was at the frame, within the quantization step
+    void checkReplayed(const World& world, std::size_t n, std::size_t frame, float step)
+    {
+        std::size_t count = 0;
+        for (const Transformation& t : world.view<Transformation>())
+        {
+            glm::vec3 p = t.translation();
+            std::size_t i = static_cast<std::size_t>(std::lround(p.x));
+            check(i < n && std::abs(p.y - streamHeight(i, frame)) <= step, "replayed positions match the recorded ones");
+            ++count;
+        }
+        check(count == n, "replay builds every recorded entity");
+    }
+
+    void benchStateStream(std::size_t n)
+    {
+        constexpr std::size_t frames = 16;
+        World world{ ComponentList<Transformation>{} };
+        std::vector<Entity*> entities = createEntities(world, n);
+        for (std::size_t i = 0; i < n; ++i) entities[i]->buildComponent<Transformation>(glm::vec3{ static_cast<float>(i), 0, 0 });
+        world.update(Seconds{});
+
+        std::stringstream stream;
+        StateStreamOptions options;
+        options.keyframe_interval = 8;
+        {
+            StateStreamWriter writer(stream, options);
+            Measure m("StateStream record", n);
+            for (std::size_t f = 0; f < frames; ++f)
+            {
+                for (std::size_t i = (10 - f % 10) % 10; i < n; i += 10)
+                {
+                    Transformation& t = *entities[i]->findComponent<Transformation>();
+                    t.translation(t.translation() + glm::vec3{ 0, 1, 0 });
+                }
+                world.update(Seconds{});
+                writer.record(world, Seconds{ static_cast<float>(f) });
+            }
+            m.stop(frames * n);
+        }
+
+        World replayed{ ComponentList<Transformation, RecordedVelocity>{} };
+        StateStreamReplay replay(replayed, stream);
+        {
+            Measure m("StateStream replay", n);
+            while (replay.next()) {}
+            replayed.update(Seconds{});
+            m.stop(frames * n);
+        }
+        check(replay.frame() == frames, "replay reads every recorded frame");
+        checkReplayed(replayed, n, frames - 1, options.position_step);
+
+        //Between two keyframes, so that it replays from the one before
+        constexpr std::size_t middle = frames / 2 + 3;
+        replay.seek(middle);
+        replayed.update(Seconds{});
+        check(replay.time() == Seconds{ static_cast<float>(middle) }, "seek shows the frame asked for");
+        checkReplayed(replayed, n, middle, options.position_step);
+    }
+
+    void benchSnapshot(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<Payload>(1.f);
+        world.update(Seconds{});
+
+        std::ostringstream out;
+        {
+            Measure m("saveSnapshot", n);
+            world.saveSnapshot(ComponentList<Payload>{}, out);
+            m.stop(n);
+        }
+        std::string bytes = out.str();
+
+        World loaded{ BenchComponents{} };
+        Measure m("loadSnapshot+cleanup", n);
+        loaded.loadSnapshot(ComponentList<Payload>{}, std::as_bytes(std::span(bytes.data(), bytes.size())));
+        loaded.update(Seconds{});
+        m.stop(n);
+    }
+
+    //A truncated snapshot is rejected before anything is built
+    void checkTruncatedSnapshot()
+    {
+        using Saved = ComponentList<Payload, SparsePayload>;
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, 10))
+        {
+            e->buildComponent<Payload>(1.f);
+            e->buildComponent<SparsePayload>(2.f);
+        }
+        world.update(Seconds{});
+        std::ostringstream out;
+        world.saveSnapshot(Saved{}, out);
+        std::string bytes = out.str();
+
+        World loaded{ BenchComponents{} };
+        bool thrown = false;
+        try
+        {
+            loaded.loadSnapshot(Saved{}, std::as_bytes(std::span(bytes.data(), bytes.size() - 32)));
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        loaded.update(Seconds{});
+        check(thrown && loaded.view<Payload>().empty() && loaded.view<SparsePayload>().empty(), "a truncated snapshot leaves the world unchanged");
+        loaded.loadSnapshot(Saved{}, std::as_bytes(std::span(bytes.data(), bytes.size())));
+        loaded.update(Seconds{});
+        check(loaded.view<Payload>().size() == 10 && loaded.view<SparsePayload>().size() == 10, "a snapshot loads after a failed one");
+    }
+
+    template<bool Parallel>
+    void benchUpdate(const char* name, std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<Integrator<Parallel>>();
+        world.update(Seconds{});
+        Measure m(name, n);
+        for (int i = 0; i < 10; ++i) world.update(Seconds{ 0.001f });
+        m.stop(10 * n);
+    }
+
+    //Entities spread over the buckets 0 to 3, as Significance would for a scene mostly far from the camera
+    void benchThrottledUpdate(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        std::size_t i = 0;
+        for (Entity* e : createEntities(world, n))
+        {
+            e->buildComponent<ThrottledIntegrator>();
+            e->updateBucket(static_cast<std::uint8_t>(i++ % 4));
+        }
+        world.update(Seconds{});
+        Measure m("update throttled", n);
+        for (int u = 0; u < 16; ++u) world.update(Seconds{ 0.001f });
+        m.stop(16 * n);
+    }
+
+    //A Rotator in a higher update bucket catches up on the time it skipped at each update it is due
+    void checkThrottledRotator()
+    {
+        World world{ ComponentList<Transformation, Rotator>{} };
+        Entity& near = world.createEntity();
+        Entity& far = world.createEntity();
+        near.buildComponent<Rotator>(1.f);
+        far.buildComponent<Rotator>(1.f);
+        far.updateBucket(2);
+        world.update(Seconds{});
+
+        int due = 0;
+        for (int u = 0; u < 8; ++u)
+        {
+            Quaternion before = far.findComponent<Transformation>()->rotation();
+            world.update(Seconds{ 0.01f });
+            Quaternion after = far.findComponent<Transformation>()->rotation();
+            if (after == before) continue;
+            ++due;
+            check(std::abs(glm::dot(after, near.findComponent<Transformation>()->rotation())) > 0.9999f, "a throttled Rotator rotates by the time it skipped");
+        }
+        check(due == 2, "a Rotator in update bucket 2 updates every 4 updates");
+    }
+
+    void benchQueuedEvent(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        world.createEntity().buildComponent<Payload>();
+        world.update(Seconds{});
+        QueuedEvent<float> event;
+        event.add(world.view<Payload>()[0], &Payload::add);
+        world.addQueuedEvent(event);
+
+        {
+            Measure m("QueuedEvent::post x4", n);
+            std::vector<std::jthread> producers;
+            for (int t = 0; t < 4; ++t) producers.emplace_back([&event, n] { for (std::size_t i = 0; i < n / 4; ++i) event.post(1.f); });
+            producers.clear();
+            m.stop(n / 4 * 4);
+        }
+        {
+            Measure m("QueuedEvent dispatch", n);
+            world.update(Seconds{});
+            m.stop(n / 4 * 4);
+        }
+        //Into the nodes of the dispatched batch
+        Measure m("QueuedEvent::post reused", n);
+        for (std::size_t i = 0; i < n / 4 * 4; ++i) event.post(1.f);
+        m.stop(n / 4 * 4);
+        world.update(Seconds{});
+        sink = world.view<Payload>()[0].value;
+    }
+
+    void benchWeakRef(std::size_t n)
+    {
+        World world{ BenchComponents{} };
+        for (Entity* e : createEntities(world, n)) e->buildComponent<Payload>(1.f);
+        world.update(Seconds{});
+
+        std::vector<WeakRef<Payload>> refs;
+        refs.reserve(n);
+        for (Payload& p : world.view<Payload>()) refs.emplace_back(p);
+
+        {
+            float sum = 0;
+            Measure m("WeakRef::ptr", n);
+            for (auto& r : refs) if (Payload* p = r.ptr()) sum += p->value;
+            m.stop(n);
+            sink = sum;
+        }
+        float sum = 0;
+        Measure m("WeakRef::operator->", n);
+        for (auto& r : refs) sum += r->value;
+        m.stop(n);
+        sink = sum;
+    }
+
+    //Listeners and refs may outlive their World, as those held by global events do
+    void checkStaleWeakRef()
+    {
+        Event<float> event;
+        WeakRef<Payload> stale;
+        {
+            World world{ BenchComponents{} };
+            world.createEntity().buildComponent<Payload>(1.f);
+            world.update(Seconds{});
+            stale = world.view<Payload>()[0];
+            event.add(world.view<Payload>()[0], &Payload::add);
+        }
+        event(1.f);
+        check(!stale, "a WeakRef reads as null once its World is destroyed");
+
+        //The next World reuses the table of the destroyed one
+        World world{ BenchComponents{} };
+        world.createEntity().buildComponent<Payload>(1.f);
+        world.update(Seconds{});
+        event(1.f);
+        check(!stale && world.view<Payload>()[0].value == 1.f, "a WeakRef of a destroyed World does not resolve into the next one");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t max_scale = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    checkStaleWeakRef();
+    checkThrottledRotator();
+    checkTruncatedSnapshot();
+
+    std::printf("%-24s %9s %12s %12s\n", "benchmark", "n", "ns/op", "allocs/op");
+    for (std::size_t n = 1'000; n <= max_scale; n *= 10)
+    {
+        benchCreateEntity(n);
+        benchBuildComponent(n);
+        benchInstantiate(n);
+        benchFindComponent(n);
+        benchQuery(n);
+        benchCleanup(n);
+        benchChurn<Payload>("churn sorted", n);
+        benchChurn<SparsePayload>("churn sparse", n);
+        benchPooledChurn(n);
+        benchSpatial<ComponentStorage::OwnerSorted>("grid walk sorted", n);
+        benchSpatial<ComponentStorage::Spatial>("grid walk spatial", n);
+        benchGetAll(n);
+        benchWorldLifetime("world lifetime heap", n, false);
+        benchWorldLifetime("world lifetime arena", n, true);
+        benchChanged(n);
+        benchSnapshot(n);
+        benchStateStream(n);
+        benchUpdate<false>("update serial", n);
+        benchUpdate<true>("update parallel", n);
+        benchThrottledUpdate(n);
+        benchQueuedEvent(n);
+        benchWeakRef(n);
+    }
+}
@@ -0,0 +1,208 @@
+#ifndef CGT_BEHAVIOUR_HPP
+#define CGT_BEHAVIOUR_HPP
+
+#include "World.h"
+#include "Entity.h"
+#include "Component.h"
+#include "Event.hpp"
+#include <coroutine>
+#include <concepts>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+//Coroutine run by the World, for logic spanning several frames. It starts when called and runs until its first co_await,
+//then is resumed by the World once what it awaits happens:
+// - co_await nextTick(): at the start of the next tick, before the tick phase,
+// - co_await delay(d): once d has elapsed, through the timers of the World,
+// - co_await fired(event): once the event triggers, returning its arguments (none, one value or a tuple). Resumed during
+//   update after the queued events are dispatched, rather than from the trigger,
+// - co_await destroyed(entity): once the entity is destroyed, resumed like fired at the next update. Immediately if already destroyed.
+//A suspended behaviour costs nothing per frame, it is only referred to by what it awaits.
+//
+//The first parameter of a behaviour is the World or a WeakRef to a component, from which the World is found.
+//Components relocate when their manager sorts them, so a behaviour of a component refers to it through the WeakRef rather
+//than this. The Behaviour returned owns the coroutine and destroys it with itself, so a component storing the behaviour
+//of its own logic always finds the WeakRef valid when resumed. Behaviours are not thread safe, they run on the thread
+//calling World::update.
+class Behaviour;
+
+class BehaviourPromise : public WeakReferencable
+{
+public:
+    explicit BehaviourPromise(World& world, const auto&...)
+        : WeakReferencable(world._handles), _world(&world)
+    {
+    }
+
+    template<std::derived_from<Component> C>
+    explicit BehaviourPromise(const WeakRef<C>& self, const auto&...)
+        : BehaviourPromise(self->world())
+    {
+    }
+
+    Behaviour get_return_object();
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { throw; }
+
+    void resume()
+    {
+        std::coroutine_handle<BehaviourPromise>::from_promise(*this).resume();
+    }
+
+    //Used by the awaitables
+    void waitTick()
+    {
+        _world->resumeOnTick(*this);
+    }
+
+    void waitDelay(Seconds delay)
+    {
+        _world->schedule(delay, *this, &BehaviourPromise::resume);
+    }
+
+    //False if the entity is already destroyed, not suspending
+    bool waitDestroyed(const Entity& entity)
+    {
+        return _world->resumeOnDestroy(entity, *this);
+    }
+
+    template<typename E, typename... Args>
+    void waitEvent(E& event, std::optional<std::tuple<std::decay_t<Args>...>>& payload)
+    {
+        _event_payload = &payload;
+        event.addOnce(*this, &BehaviourPromise::onEvent<Args...>);
+    }
+
+private:
+    template<typename... Args>
+    void onEvent(Args... args)
+    {
+        static_cast<std::optional<std::tuple<std::decay_t<Args>...>>*>(_event_payload)->emplace(args...);
+        _world->readyBehaviour(*this);
+    }
+
+    World* _world;
+    void* _event_payload = nullptr; //Where the arguments of the awaited event go
+};
+
+class [[nodiscard]] Behaviour
+{
+public:
+    using promise_type = BehaviourPromise;
+
+    Behaviour() = default;
+    explicit Behaviour(std::coroutine_handle<BehaviourPromise> handle) : _handle(handle) {}
+    Behaviour(Behaviour&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    Behaviour& operator=(Behaviour&& other) noexcept
+    {
+        std::swap(_handle, other._handle);
+        return *this;
+    }
+    ~Behaviour()
+    {
+        if (_handle) _handle.destroy();
+    }
+
+    //True once the coroutine returned, or for an empty behaviour
+    bool done() const
+    {
+        return !_handle || _handle.done();
+    }
+
+private:
+    std::coroutine_handle<BehaviourPromise> _handle;
+};
+
+inline Behaviour BehaviourPromise::get_return_object()
+{
+    return Behaviour(std::coroutine_handle<BehaviourPromise>::from_promise(*this));
+}
+
+namespace impl
+{
+    struct NextTickAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<BehaviourPromise> h) const
+        {
+            h.promise().waitTick();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct DelayAwaiter
+    {
+        bool await_ready() const noexcept { return delay <= Seconds{}; }
+        void await_suspend(std::coroutine_handle<BehaviourPromise> h) const
+        {
+            h.promise().waitDelay(delay);
+        }
+        void await_resume() const noexcept {}
+
+        Seconds delay;
+    };
+
+    struct DestroyedAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<BehaviourPromise> h) const
+        {
+            return h.promise().waitDestroyed(entity);
+        }
+        void await_resume() const noexcept {}
+
+        const Entity& entity;
+    };
+
+    template<typename E, typename... Args>
+    struct EventAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<BehaviourPromise> h)
+        {
+            h.promise().template waitEvent<E, Args...>(event, payload);
+        }
+        auto await_resume()
+        {
+            if constexpr (sizeof...(Args) == 1) return std::get<0>(std::move(*payload));
+            else if constexpr (sizeof...(Args) > 1) return std::move(*payload);
+        }
+
+        E& event;
+        std::optional<std::tuple<std::decay_t<Args>...>> payload;
+    };
+}
+
+inline impl::NextTickAwaiter nextTick()
+{
+    return {};
+}
+
+inline impl::DelayAwaiter delay(Seconds d)
+{
+    return { d };
+}
+
+inline impl::DestroyedAwaiter destroyed(const Entity& entity)
+{
+    return { entity };
+}
+
+//Also takes a QueuedEvent, resumed after the dispatch of the first payload of a batch
+template<typename... Args>
+impl::EventAwaiter<Event<Args...>, Args...> fired(Event<Args...>& event)
+{
+    return { event, std::nullopt };
+}
+
+template<typename T, typename... Args>
+impl::EventAwaiter<PrivateEvent<T, Args...>, Args...> fired(PrivateEvent<T, Args...>& event)
+{
+    return { event, std::nullopt };
+}
+
+#endif
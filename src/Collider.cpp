@@ -2,9 +2,23 @@
 #include "Physics.h"
 #include <glm/gtx/norm.hpp>
 
+CollisionVolume::CollisionVolume(const EntityKey& key, const Snapshot& s)
+    : DependentComponent(key)
+{
+    if (s.shape == 0) volume = CollisionSphere{ s.size.x };
+    else volume = CollisionBox{ s.size };
+}
+
+CollisionVolume::Snapshot CollisionVolume::snapshot(const SnapshotWriter&) const
+{
+    if (auto* sphere = std::get_if<CollisionSphere>(&volume)) return { 0, { sphere->radius, 0, 0 } };
+    return { 1, std::get<CollisionBox>(volume).extents };
+}
+
+//Only the volumes of active entities are registered, those released to an EntityPool are removed until acquired again
 void CollisionVolume::start()
 {
-    Physics::instance().add(*this);
+    if (owner().active()) Physics::instance().add(*this);
 }
 
 void CollisionVolume::stop()
@@ -12,6 +26,16 @@ void CollisionVolume::stop()
     Physics::instance().remove(*this);
 }
 
+void CollisionVolume::activate()
+{
+    Physics::instance().add(*this);
+}
+
+void CollisionVolume::deactivate()
+{
+    Physics::instance().remove(*this);
+}
+
 namespace
 {
     Sphere build(const CollisionSphere& s, const Transformation& t)
@@ -30,9 +54,24 @@ AnyCol CollisionVolume::buildCollisions() const
 }
 
 
+PhysicsMovement::PhysicsMovement(const EntityKey& key)
+    : DependentComponent(key), HotFields({}, 10.f, { 0, -9.81f, 0 }, 0.1f, {})
+{
+}
+
+PhysicsMovement::PhysicsMovement(const EntityKey& key, const Snapshot& s)
+    : DependentComponent(key), HotFields(s.velocity, s.mass, s.gravity, s.drag, {}), cr(s.cr), angular_drag(s.angular_drag), _angular_velocity(s.angular_velocity)
+{
+}
+
+PhysicsMovement::Snapshot PhysicsMovement::snapshot(const SnapshotWriter&) const
+{
+    return { velocity(), mass(), gravity(), drag(), cr, angular_drag, _angular_velocity };
+}
+
 void PhysicsMovement::start()
 {
-    Physics::instance().add(*this);
+    if (owner().active()) Physics::instance().add(*this);
 }
 
 void PhysicsMovement::stop()
@@ -40,13 +79,39 @@ void PhysicsMovement::stop()
     Physics::instance().remove(*this);
 }
 
+void PhysicsMovement::activate()
+{
+    hot<Velocity>() = {};
+    _angular_velocity = {};
+    Physics::instance().add(*this);
+}
+
+void PhysicsMovement::deactivate()
+{
+    Physics::instance().remove(*this);
+}
+
+void PhysicsMovement::tickHot(Seconds, View hot)
+{
+    auto velocities = hot.column<Velocity>();
+    auto masses = hot.column<Mass>();
+    auto gravities = hot.column<Gravity>();
+    auto drags = hot.column<Drag>();
+    auto forces = hot.column<Forces>();
+    for (std::size_t i = 0; i < hot.size(); ++i)
+    {
+        forces[i] = gravities[i] * masses[i] - drags[i] * velocities[i];
+    }
+}
+
 void PhysicsMovement::tick(Seconds delta)
 {
     using std::cos, std::sin, std::abs;
     Transformation& t = get<Transformation>();
     CollisionVolume& cv = get<CollisionVolume>();
+    glm::vec3& velocity = hot<Velocity>();
 
-    glm::vec3 forces = gravity * mass - drag * _velocity;
+    glm::vec3 forces = hot<Forces>();
 
     auto col = cv.buildCollisions();
     for (auto* other_cv : Physics::instance().overlap(growBy(col, TinyLength * 5)))
@@ -56,7 +121,7 @@ void PhysicsMovement::tick(Seconds delta)
         {
             glm::vec3 normal_force = -dot(forces, result->normal) * result->normal;
             forces += normal_force;
-            glm::vec3 bitangent = cross(normal_force, _velocity);
+            glm::vec3 bitangent = cross(normal_force, velocity);
             glm::vec3 tangent_force{};
             if (length2(bitangent) > 0)
             {
@@ -69,8 +134,8 @@ void PhysicsMovement::tick(Seconds delta)
     }
 
     glm::vec3 origin = t.translation();
-    _velocity += forces / mass * delta.count();
-    glm::vec3 movement = _velocity * delta.count();
+    velocity += forces / hot<Mass>() * delta.count();
+    glm::vec3 movement = velocity * delta.count();
     while (auto result = Physics::instance().sweep(cv, movement))
     {
         t.translation(t.translation() + movement * result->t);
@@ -78,13 +143,12 @@ void PhysicsMovement::tick(Seconds delta)
         auto other_col = result->other->buildCollisions();
         do
         {
-            auto bf = t.translation();
             t.translation(t.translation() + result->normal * sign(dot(t.translation() - other_pos, result->normal)) * TinyLength);
         } while (intersect(cv.buildCollisions(), other_col));
 
         handleBounce(*result, result->other_physics);
         delta *= 1 - result->t;
-        movement = _velocity * delta.count();
+        movement = velocity * delta.count();
     }
     t.translation(t.translation() + movement);
     glm::vec3 total_movement = t.translation() - origin;
@@ -138,12 +202,42 @@ void PhysicsMovement::tick(Seconds delta)
 
 glm::vec3 PhysicsMovement::velocity() const
 {
-    return _velocity;
+    return hot<Velocity>();
 }
 
 void PhysicsMovement::velocity(glm::vec3 v)
 {
-    _velocity = v;
+    hot<Velocity>() = v;
+}
+
+float PhysicsMovement::mass() const
+{
+    return hot<Mass>();
+}
+
+void PhysicsMovement::mass(float m)
+{
+    hot<Mass>() = m;
+}
+
+glm::vec3 PhysicsMovement::gravity() const
+{
+    return hot<Gravity>();
+}
+
+void PhysicsMovement::gravity(glm::vec3 g)
+{
+    hot<Gravity>() = g;
+}
+
+float PhysicsMovement::drag() const
+{
+    return hot<Drag>();
+}
+
+void PhysicsMovement::drag(float d)
+{
+    hot<Drag>() = d;
 }
 
 void PhysicsMovement::handleBounce(const Intersection& intersection, PhysicsMovement* other)
@@ -152,26 +246,26 @@ void PhysicsMovement::handleBounce(const Intersection& intersection, PhysicsMove
     if (other)
     {
         auto [odiff, oangular_diff] = other->calcBounceDiff(intersection, this);
-        other->_velocity += odiff;
+        other->hot<Velocity>() += odiff;
         other->_angular_velocity += _angular_velocity;
     }
-    _velocity += diff;
+    hot<Velocity>() += diff;
     _angular_velocity += angular_diff;
 }
 
 std::pair<glm::vec3, glm::vec3> PhysicsMovement::calcBounceDiff(const Intersection& intersection, PhysicsMovement* other) const
 {
     glm::vec3 r = intersection.contact - get<Transformation>().translation();
-    float denom = (1 + dot(intersection.normal, cross(cross(r, intersection.normal), r))) / mass;
-    glm::vec3 v = _velocity;
+    float denom = (1 + dot(intersection.normal, cross(cross(r, intersection.normal), r))) / hot<Mass>();
+    glm::vec3 v = hot<Velocity>();
     if (other)
     {
         glm::vec3 rb = intersection.contact - other->get<Transformation>().translation();
-        denom += (1 + dot(intersection.normal, cross(cross(rb, intersection.normal), rb))) / other->mass;
-        v -= other->_velocity;
+        denom += (1 + dot(intersection.normal, cross(cross(rb, intersection.normal), rb))) / other->hot<Mass>();
+        v -= other->hot<Velocity>();
     }
 
-    denom *= mass;
+    denom *= hot<Mass>();
     glm::vec3 diff = -(1 + cr) * dot(v, intersection.normal) / denom * intersection.normal;
 
     return { diff, cross(r, diff) };
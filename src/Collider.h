@@ -5,8 +5,10 @@
 #include "Transformation.h"
 #include "Event.hpp"
 #include "Geometry.h"
+#include "HotFields.hpp"
 #include <variant>
 #include <vector>
+#include <cstdint>
 
 struct CollisionSphere
 {
@@ -21,10 +23,20 @@ struct CollisionBox
 class CollisionVolume : public DependentComponent<Transformation>
 {
 public:
+    struct Snapshot
+    {
+        std::uint32_t shape; //Index in volume
+        glm::vec3 size; //Radius in x for a sphere, extents for a box
+    };
+
     using DependentComponent::DependentComponent;
+    CollisionVolume(const EntityKey& key, const Snapshot& s);
+    Snapshot snapshot(const SnapshotWriter& writer) const;
 
     void start();
     void stop();
+    void activate();
+    void deactivate();
 
     AnyCol buildCollisions() const;
 
@@ -32,27 +44,48 @@ public:
 private:
 };
 
-class PhysicsMovement : public DependentComponent<Transformation,CollisionVolume>
+//Velocity, mass, gravity, drag and the external forces of the tick are hot fields
+class PhysicsMovement : public DependentComponent<Transformation,CollisionVolume>, public HotFields<glm::vec3, float, glm::vec3, float, glm::vec3>
 {
 public:
-    using DependentComponent::DependentComponent;
+    struct Snapshot
+    {
+        glm::vec3 velocity;
+        float mass;
+        glm::vec3 gravity;
+        float drag;
+        float cr;
+        float angular_drag;
+        glm::vec3 angular_velocity;
+    };
+
+    PhysicsMovement(const EntityKey& key);
+    PhysicsMovement(const EntityKey& key, const Snapshot& s);
+    Snapshot snapshot(const SnapshotWriter& writer) const;
 
     void start();
     void stop();
+    void activate(); //Reused from an EntityPool, at rest
+    void deactivate();
+    static void tickHot(Seconds delta, View hot);
     void tick(Seconds delta);
 
     glm::vec3 velocity() const;
     void velocity(glm::vec3 v);
+    float mass() const;
+    void mass(float m);
+    glm::vec3 gravity() const;
+    void gravity(glm::vec3 g);
+    float drag() const;
+    void drag(float d);
 
-    glm::vec3 gravity{ 0, -9.81f, 0 };
     float cr = 0.8f;
-    float drag = 0.1f;
     float angular_drag = 0.01f;
-    float mass = 10.f;
 private:
+    enum Hot { Velocity, Mass, Gravity, Drag, Forces };
+
     void handleBounce(const Intersection& intersection, PhysicsMovement* other);
     std::pair<glm::vec3, glm::vec3> calcBounceDiff(const Intersection& intersection, PhysicsMovement* other) const;
-    glm::vec3 _velocity{};
     glm::vec3 _angular_velocity{};
 };
 
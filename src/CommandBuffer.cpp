@@ -0,0 +1,153 @@
+#include "CommandBuffer.h"
+#include "Entity.h"
+#include "Component.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr std::size_t NotPending = ~std::size_t{};
+}
+
+CommandBuffer::EntityTarget::EntityTarget(Entity& e)
+    : _entity(e), _pending(NotPending)
+{
+}
+
+CommandBuffer::EntityTarget::EntityTarget(PendingEntity p)
+    : _pending(p.index)
+{
+}
+
+Entity* CommandBuffer::EntityTarget::resolve(const std::vector<Entity*>& created) const
+{
+    return _pending == NotPending ? _entity.ptr() : created[_pending];
+}
+
+CommandBuffer::CommandBuffer(CommandBuffer&& other) noexcept
+    : _blocks(std::move(other._blocks)), _block(std::exchange(other._block, 0)), _offset(std::exchange(other._offset, 0)),
+    _commands(std::move(other._commands)), _created(std::exchange(other._created, 0))
+{
+}
+
+CommandBuffer& CommandBuffer::operator=(CommandBuffer&& other) noexcept
+{
+    if (&other == this) return *this;
+
+    //The blocks are swapped rather than freed, other keeps them for its next commands
+    clear();
+    std::swap(_blocks, other._blocks);
+    std::swap(_block, other._block);
+    std::swap(_offset, other._offset);
+    std::swap(_commands, other._commands);
+    std::swap(_created, other._created);
+    return *this;
+}
+
+CommandBuffer::~CommandBuffer()
+{
+    clear();
+}
+
+void* CommandBuffer::allocate(std::size_t bytes, std::size_t alignment)
+{
+    while (_block < _blocks.size())
+    {
+        Block& b = _blocks[_block];
+        void* p = b.data.get() + _offset;
+        std::size_t space = b.size - _offset;
+        if (std::align(alignment, bytes, p, space))
+        {
+            _offset = b.size - space + bytes;
+            return p;
+        }
+        ++_block;
+        _offset = 0;
+    }
+
+    std::size_t size = std::max({ InitialBlockSize, bytes + alignment, _blocks.empty() ? 0 : 2 * _blocks.back().size });
+    _blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+    _block = _blocks.size() - 1;
+    _offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void CommandBuffer::clear()
+{
+    for (Command* command : _commands) command->~Command();
+    _commands.clear();
+    _block = 0;
+    _offset = 0;
+    _created = 0;
+}
+
+CommandBuffer::PendingEntity CommandBuffer::createEntity()
+{
+    struct CreateCommand : Command
+    {
+        void apply(World& world, std::vector<Entity*>& created) override
+        {
+            created.push_back(&world.createEntity());
+        }
+    };
+
+    record<CreateCommand>();
+    return { _created++ };
+}
+
+void CommandBuffer::destroy(EntityTarget target)
+{
+    struct DestroyEntityCommand : Command
+    {
+        DestroyEntityCommand(EntityTarget t) : target(std::move(t)) {}
+        void apply(World&, std::vector<Entity*>& created) override
+        {
+            if (Entity* e = target.resolve(created)) e->destroy();
+        }
+        EntityTarget target;
+    };
+
+    record<DestroyEntityCommand>(std::move(target));
+}
+
+void CommandBuffer::release(EntityTarget target)
+{
+    struct ReleaseCommand : Command
+    {
+        ReleaseCommand(EntityTarget t) : target(std::move(t)) {}
+        void apply(World&, std::vector<Entity*>& created) override
+        {
+            if (Entity* e = target.resolve(created)) e->release();
+        }
+        EntityTarget target;
+    };
+
+    record<ReleaseCommand>(std::move(target));
+}
+
+void CommandBuffer::destroy(Component& c)
+{
+    struct DestroyComponentCommand : Command
+    {
+        DestroyComponentCommand(Component& c) : target(c) {}
+        void apply(World&, std::vector<Entity*>&) override
+        {
+            if (Component* c = target.ptr()) c->destroy();
+        }
+        WeakRef<Component> target;
+    };
+
+    record<DestroyComponentCommand>(c);
+}
+
+bool CommandBuffer::empty() const
+{
+    return _commands.empty();
+}
+
+void CommandBuffer::apply(World& world)
+{
+    std::vector<Entity*> created;
+    created.reserve(_created);
+    for (Command* command : _commands) command->apply(world, created);
+    clear();
+}
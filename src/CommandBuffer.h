@@ -0,0 +1,129 @@
+#ifndef CGT_COMMANDBUFFER_H
+#define CGT_COMMANDBUFFER_H
+
+#include "WeakRef.hpp"
+#include <vector>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+class World;
+class Entity;
+class Component;
+
+//Records structural changes (entity creation, component building, destruction) so that they can be made from any thread.
+//A buffer itself is not synchronized: each thread records into its own and hands it to World::submit, which is thread safe.
+//Submitted buffers are applied in order on the main thread, at the World sync point between the update phase and the cleanup.
+class CommandBuffer
+{
+public:
+    //Entity created by an earlier command of the same buffer
+    struct PendingEntity
+    {
+        std::size_t index;
+    };
+
+    //Either an existing entity or a pending one
+    class EntityTarget
+    {
+        friend class CommandBuffer;
+    public:
+        EntityTarget(Entity& e);
+        EntityTarget(PendingEntity p);
+    private:
+        Entity* resolve(const std::vector<Entity*>& created) const;
+
+        WeakRef<Entity> _entity;
+        std::size_t _pending;
+    };
+
+    CommandBuffer() = default;
+    CommandBuffer(CommandBuffer&& other) noexcept;
+    CommandBuffer& operator=(CommandBuffer&& other) noexcept;
+    ~CommandBuffer();
+
+    PendingEntity createEntity();
+
+    //The arguments are copied or moved into the buffer. Ignored if the target entity no longer exists when applied
+    template<typename T, typename... Args>
+    void buildComponent(EntityTarget target, Args&&... args)
+    {
+        record<BuildCommand<T, Entity, std::decay_t<Args>...>>(std::move(target), std::forward<Args>(args)...);
+    }
+
+    void destroy(EntityTarget target);
+    void destroy(Component& c);
+    void release(EntityTarget target); //See Entity::release
+
+    bool empty() const;
+    void apply(World& world); //Keeps the memory of the commands for the next ones
+
+private:
+    struct Command
+    {
+        virtual ~Command() = default;
+        virtual void apply(World& world, std::vector<Entity*>& created) = 0;
+    };
+
+    //E is always Entity, as a template parameter so that it is only required to be complete when instantiated
+    template<typename T, typename E, typename... Args>
+    struct BuildCommand : Command
+    {
+        template<typename... CArgs>
+        BuildCommand(EntityTarget t, CArgs&&... a)
+            : target(std::move(t)), args(std::forward<CArgs>(a)...)
+        {
+        }
+
+        void apply(World&, std::vector<Entity*>& created) override
+        {
+            if (E* e = target.resolve(created))
+            {
+                std::apply([e](Args&... a) { e->template buildComponent<T>(std::move(a)...); }, args);
+            }
+        }
+
+        EntityTarget target;
+        std::tuple<Args...> args;
+    };
+
+    //Constructs the command in the arena of the buffer
+    template<typename Cmd, typename... CArgs>
+    void record(CArgs&&... args)
+    {
+        void* storage = allocate(sizeof(Cmd), alignof(Cmd));
+        Command*& command = _commands.emplace_back(nullptr);
+        try
+        {
+            command = new (storage) Cmd(std::forward<CArgs>(args)...);
+        }
+        catch (...)
+        {
+            _commands.pop_back();
+            throw;
+        }
+    }
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+    void clear(); //Destroys the commands and rewinds the arena
+
+    //Bump arena for the commands, rather than one heap allocation each. Its blocks are kept once applied, and the World
+    //hands applied buffers back to the managers, so that steady state recording does not touch the heap
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+    static constexpr std::size_t InitialBlockSize = 4 * 1024;
+
+    std::vector<Block> _blocks;
+    std::size_t _block = 0; //Commands go to _blocks[_block] from _offset
+    std::size_t _offset = 0;
+    std::vector<Command*> _commands; //In _blocks, in recording order
+    std::size_t _created = 0;
+};
+
+#endif
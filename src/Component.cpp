@@ -2,7 +2,7 @@
 #include "Entity.h"
 
 Component::Component(const EntityKey& key)
-    : _owner(key.ptr)
+    : WeakReferencable(key.ptr->world()._handles), _owner(key.ptr)
 {
 }
 
@@ -24,10 +24,16 @@ World& Component::world() const
 
 void Component::checkDestroy()
 {
-    if(shouldDestroy()) world()._should_cleanup = true;
+    if(shouldDestroy()) world().requestCleanup(_type, this);
 }
 
 bool Component::shouldDestroy() const
 {
-    return _owner->_marked_for_destroy || _marked_for_destroy && _clients == 0;
+    return _owner->_marked_for_destroy || (_marked_for_destroy && _clients == 0);
+}
+
+bool Component::shouldSkip() const
+{
+    const Entity& owner = *_owner;
+    return !owner._active || owner._marked_for_destroy || (_marked_for_destroy && _clients == 0);
 }
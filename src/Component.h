@@ -4,6 +4,8 @@
 #include "WeakRef.hpp"
 #include "Entity.h"
 #include <tuple>
+#include <utility>
+#include <cstdint>
 
 class Entity;
 struct EntityKey;
@@ -34,12 +36,59 @@ protected:
 private:
     void checkDestroy();
     bool shouldDestroy() const;
+    bool shouldSkip() const; //By the update, tick and draw phases: destroyed or owned by an inactive entity, see EntityPool
 
     WeakRef<Entity> _owner;
     unsigned short _clients = 0;
+    ComponentTypeId _type = NoComponentType; //Set by the manager once built
     bool _marked_for_destroy = false;
 };
 
+//Opt-in base for components recording the World::changeVersion at which they last changed. They call markChanged
+//from whatever changes their state, and count as changed when built
+class ChangeTracked
+{
+    friend class World;
+    template<typename C>
+    friend class ComponentManager;
+public:
+    std::uint32_t changedVersion() const { return _changed_version; }
+    bool changedSince(std::uint32_t version) const { return _changed_version > version; }
+
+protected:
+    void markChanged(const World& world)
+    {
+        _changed_version = world.changeVersion();
+        if (_blocks) _blocks->mark(&_changed_version, _changed_version);
+    }
+
+private:
+    std::uint32_t _changed_version = 0;
+    ChangeBlocks* _blocks = nullptr; //Of the manager, set once built
+};
+
+//Opt-in base for components whose update may be skipped on the entities given a higher Entity::updateBucket, such as far
+//away or hidden ones, see Significance. Their update then runs once every 2^bucket updates with the deltas of the skipped
+//updates added up. The components of a bucket are spread over its updates by build order, so that their cost is too.
+//Only update is throttled, the hot passes and the tick phase run every time
+class Throttled
+{
+    template<typename C>
+    friend class ComponentManager;
+private:
+    //Adds delta to the skipped time and, when due at this update, replaces delta with the time to update by
+    bool due(std::uint32_t update, unsigned period, Seconds& delta)
+    {
+        _skipped += delta;
+        if ((update + _phase) & (period - 1)) return false;
+        delta = std::exchange(_skipped, Seconds{});
+        return true;
+    }
+
+    Seconds _skipped{};
+    std::uint32_t _phase = 0; //Set by the manager
+};
+
 template<typename T, typename... Args>
 concept oneOf = (std::is_same_v<T, Args> || ...);
 
@@ -47,6 +96,8 @@ template<typename... Comps>
 class DependentComponent : public Component
 {
 public:
+    using Dependencies = std::tuple<Comps...>;
+
     DependentComponent(const EntityKey& key)
         : Component(key), _dependencies{ owner().getOrBuildComponent<Comps>()... }
     {
@@ -2,76 +2,406 @@
 #define CGT_COMPONENTMANAGER_HPP
 
 #include <vector>
+#include <tuple>
+#include <algorithm>
 #include <chrono>
 #include <utility>
 #include <glm/glm.hpp>
-#include <forward_list>
+#include <memory_resource>
+#include <concepts>
+#include <cstdint>
+#include <atomic>
+#include <limits>
+#include <span>
+#include <mutex>
+#include <functional>
 #include "Utility.h"
+#include "WeakRef.hpp"
+#include "HotFields.hpp"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "CommandBuffer.h"
+#include "Jobs.h"
 
 
 class Entity;
+class World;
+class Component;
+class Throttled;
+class ChangeTracked;
 
 
 using Seconds = std::chrono::duration<float>;
+using ComponentTypeId = std::uint16_t;
+inline constexpr ComponentTypeId NoComponentType = std::numeric_limits<ComponentTypeId>::max();
+
+namespace impl
+{
+    inline ComponentTypeId nextComponentTypeId()
+    {
+        static std::atomic<ComponentTypeId> next = 0;
+        return next++;
+    }
+}
+
+//Dense id of a component type, assigned on first use. Used to index the managers of a World
+template<typename C>
+ComponentTypeId componentTypeId()
+{
+    static const ComponentTypeId id = impl::nextComponentTypeId();
+    return id;
+}
+
+//update and tick may also take a CommandBuffer&, applied like the buffers given to World::submit
+template<typename C>
+concept HasUpdatePhase = requires (C& c, Seconds delta) { c.update(delta); } || requires (C& c, Seconds delta, CommandBuffer& b) { c.update(delta, b); }
+    || requires (typename C::View v, Seconds delta) { C::updateHot(delta, v); };
+template<typename C>
+concept HasTickPhase = requires (C& c, Seconds delta) { c.tick(delta); } || requires (C& c, Seconds delta, CommandBuffer& b) { c.tick(delta, b); }
+    || requires (typename C::View v, Seconds delta) { C::tickHot(delta, v); };
+template<typename C>
+concept HasBeginTickPhase = requires (C& c) { c.beginTick(); };
+template<typename C>
+concept HasDrawPhase = requires (const C& c, const glm::mat4& m) { c.draw(m, m); };
+template<typename C>
+concept HasDrawGeometryPhase = requires (const C& c, const glm::mat4& m) { c.drawGeometry(m, m); };
+
+//Which of the per frame phases a manager has any work for, so that the World only calls the relevant ones
+struct ManagerPhases
+{
+    bool update;
+    bool tick;
+    bool begin_tick;
+    bool draw;
+    bool draw_geometry;
+};
+
+//Component types the update and tick of a manager may touch, used to decide which managers can run concurrently.
+//Every access counts as a write. It is made of the component type itself, its DependentComponent dependencies and the
+//types listed in an optional "using Accesses = std::tuple<...>". Components whose update or tick has side effects beyond
+//that (building components or entities, triggering events, writing globals...) must declare "static constexpr bool exclusive = true".
+//Destroying an entity is allowed without being exclusive.
+struct ManagerAccess
+{
+    std::vector<ComponentTypeId> writes;
+    bool exclusive;
+
+    bool conflictsWith(const ManagerAccess& other) const
+    {
+        if (exclusive || other.exclusive) return true;
+        return std::any_of(writes.begin(), writes.end(), [&other](ComponentTypeId id) {
+            return std::find(other.writes.begin(), other.writes.end(), id) != other.writes.end();
+        });
+    }
+};
+
+template<typename C>
+concept ExclusiveComponent = requires { requires C::exclusive; };
+
+//Component types declaring "static constexpr bool parallel = true" have their update and tick split in chunks run concurrently
+//on the WorkerPool. Each component may then only touch itself and the components of its own entity, anything shared goes through
+//the CommandBuffer given to update or tick. The buffers of the chunks are submitted in order, so that the result is the same
+//as running the components one after the other
+template<typename C>
+concept ParallelComponent = requires { requires C::parallel; };
+
+//Smallest chunk of a ParallelComponent manager, below which splitting costs more than it saves
+inline constexpr std::size_t MinParallelChunk = 256;
+
+//How a manager stores its components, chosen by a component type with "static constexpr ComponentStorage storage = ...".
+//OwnerSorted keeps them sorted by owner, merging the new ones in and compacting the destroyed ones at every cleanup, which
+//costs a pass over all of them. Query joins on that order.
+//Sparse appends the new ones and swap removes the destroyed ones, so a cleanup only costs the components added and removed.
+//The order is then arbitrary and changes when components are removed, meant for types with many short lived components
+//that are not queried. Entities still find them in constant time through their WeakRef, the HandleTable being the sparse side.
+//Spatial is Sparse storage also sorted along a Z-order curve every World::spatialReorderPeriod updates, so that components
+//close in space are close in memory. The type provides "glm::vec3 spatialPosition() const", usually its world position.
+enum class ComponentStorage
+{
+    OwnerSorted,
+    Sparse,
+    Spatial
+};
+
+template<typename C>
+constexpr ComponentStorage componentStorage()
+{
+    if constexpr (requires { C::storage; }) return C::storage;
+    else return ComponentStorage::OwnerSorted;
+}
+
+//Not sorted by owner, stored as Sparse or Spatial
+template<typename C>
+concept SparseComponent = componentStorage<C>() != ComponentStorage::OwnerSorted;
+
+template<typename C>
+concept SpatialComponent = componentStorage<C>() == ComponentStorage::Spatial;
+
+namespace impl
+{
+    //Interleaves the low 21 bits of v with two zero bits after each
+    inline std::uint64_t spreadMortonBits(std::uint32_t v)
+    {
+        std::uint64_t x = v & 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffff;
+        x = (x | x << 16) & 0x1f0000ff0000ff;
+        x = (x | x << 8) & 0x100f00f00f00f00f;
+        x = (x | x << 4) & 0x10c30c30c30c30c3;
+        x = (x | x << 2) & 0x1249249249249249;
+        return x;
+    }
+
+    //Position along a Z-order curve of a point quantized to 21 bits per axis
+    inline std::uint64_t mortonCode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+    {
+        return spreadMortonBits(x) | spreadMortonBits(y) << 1 | spreadMortonBits(z) << 2;
+    }
+}
+
+namespace impl
+{
+    template<typename C, typename... Deps, typename... Extra>
+    ManagerAccess makeAccess(std::tuple<Deps...>*, std::tuple<Extra...>*)
+    {
+        return { { componentTypeId<C>(), componentTypeId<Deps>()..., componentTypeId<Extra>()... }, ExclusiveComponent<C> };
+    }
+
+    template<typename C>
+    auto* dependenciesOf()
+    {
+        if constexpr (requires { typename C::Dependencies; }) return static_cast<typename C::Dependencies*>(nullptr);
+        else return static_cast<std::tuple<>*>(nullptr);
+    }
+
+    template<typename C>
+    auto* accessesOf()
+    {
+        if constexpr (requires { typename C::Accesses; }) return static_cast<typename C::Accesses*>(nullptr);
+        else return static_cast<std::tuple<>*>(nullptr);
+    }
+}
+
+template<typename C>
+ManagerAccess managerAccess()
+{
+    return impl::makeAccess<C>(impl::dependenciesOf<C>(), impl::accessesOf<C>());
+}
 
 class ComponentManagerBase
 {
+    friend class World;
 public:
+    ComponentManagerBase(ManagerPhases phases, ManagerAccess access, ComponentStorage storage, std::pmr::memory_resource* resource)
+        : _destroyed(resource), _phases(phases), _access(std::move(access)), _storage(storage) {}
     virtual ~ComponentManagerBase() = default;
+    ManagerPhases phases() const { return _phases; }
+    const ManagerAccess& access() const { return _access; }
+    ComponentStorage storage() const { return _storage; }
     virtual void update(Seconds delta) = 0;
     virtual void tick(Seconds delta) = 0;
+    virtual void beginTick() = 0;
     virtual void draw(const glm::mat4& v, const glm::mat4& p) const = 0;
     virtual void drawGeometry(const glm::mat4& v, const glm::mat4& p) const = 0;
     virtual void cleanup(Seconds delta) = 0;
+    virtual void stopAll() = 0;
+    virtual void activate(Component& c, bool active) = 0;
 protected:
+    void submitCommands(CommandBuffer& commands); //Leaves commands empty, defined in World.cpp
+
+    std::mutex _destroyed_mutex;
+    std::pmr::vector<WeakRef<Component>> _destroyed; //Reported by World::requestCleanup for Sparse storage, may hold duplicates
+    std::atomic<bool> _destroy_requested = false; //Set by World::requestCleanup when a component is destroyed
+    bool _reorder_requested = false; //Set by the World for Spatial storage, done at the next cleanup
+private:
+    World* _world = nullptr;
+    ManagerPhases _phases;
+    ManagerAccess _access;
+    ComponentStorage _storage;
+    std::atomic<bool> _cleanup_requested = false; //Only the managers with destroyed or new components are cleaned up
 };
 
 template<typename C>
-class ComponentManager : public ComponentManagerBase
+concept HasHotFields = requires { typename C::HotFieldsType; } && std::derived_from<C, typename C::HotFieldsType>;
+
+template<typename C>
+struct HotStorage
+{
+    explicit HotStorage(std::pmr::memory_resource*) {}
+};
+
+template<HasHotFields C>
+struct HotStorage<C>
+{
+    explicit HotStorage(std::pmr::memory_resource* resource) : columns(resource), order(resource) {}
+
+    typename C::Columns columns;
+    std::pmr::vector<std::size_t> order;
+};
+
+//Latest change version of each block of BlockSize consecutive stored components of a ChangeTracked type, so that
+//World::changed only visits the blocks changed since. Rebuilt by the cleanup, which is when the components move
+struct ChangeBlocks
+{
+    static constexpr std::size_t BlockSize = 64;
+
+    explicit ChangeBlocks(std::pmr::memory_resource* resource) : versions(resource) {}
+
+    //Called by markChanged with the version of a component, ignored for those not stored yet. Thread safe
+    void mark(const std::uint32_t* tracked, std::uint32_t version)
+    {
+        std::uintptr_t offset = reinterpret_cast<std::uintptr_t>(tracked) - first;
+        if (offset >= count * stride) return;
+        std::atomic_ref<std::uint32_t>(versions[offset / stride / BlockSize]).store(version, std::memory_order_relaxed);
+    }
+
+    std::uintptr_t first = 0; //Address of the version of the first stored component
+    std::size_t stride = 0;
+    std::size_t count = 0;
+    std::pmr::vector<std::uint32_t> versions;
+};
+
+template<typename C>
+struct ChangeStorage
+{
+    explicit ChangeStorage(std::pmr::memory_resource*) {}
+};
+
+template<std::derived_from<ChangeTracked> C>
+struct ChangeStorage<C>
+{
+    explicit ChangeStorage(std::pmr::memory_resource* resource) : blocks(resource) {}
+
+    ChangeBlocks blocks;
+};
+
+template<typename C>
+class ComponentManager final : public ComponentManagerBase
 {
 public:
+    //Every container of the manager allocates from the resource, which must outlive it
+    explicit ComponentManager(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : ComponentManagerBase({ HasUpdatePhase<C>, HasTickPhase<C>, HasBeginTickPhase<C>, HasDrawPhase<C>, HasDrawGeometryPhase<C> }, managerAccess<C>(),
+            componentStorage<C>(), resource),
+        _components(resource), _activated(resource), _new_components(resource), _chunk_commands(resource), _removing(resource), _hot(resource), _changes(resource)
+    {
+    }
+
     void update(const Seconds delta) override
     {
-        if constexpr (requires (C& c) { c.update(delta); })
-        {
-            for (auto& c : _components) if (!c.shouldDestroy()) c.update(delta);
-        }
+        CGT_PROFILE_ZONE("update", profilerTypeName<C>());
+        const std::uint32_t update_index = _update_count++;
+        forEachChunk([this, delta, update_index](std::size_t first, std::size_t count, CommandBuffer& commands) {
+            if constexpr (requires (typename C::View v) { C::updateHot(delta, v); })
+            {
+                C::updateHot(delta, _hot.columns.view(first, count));
+            }
+            if constexpr (requires (C& c) { c.update(delta, commands); })
+            {
+                for (C& c : components().subspan(first, count))
+                {
+                    Seconds d = delta;
+                    if (!c.shouldSkip() && isDue(c, update_index, d)) c.update(d, commands);
+                }
+            }
+            else if constexpr (requires (C& c) { c.update(delta); })
+            {
+                for (C& c : components().subspan(first, count))
+                {
+                    Seconds d = delta;
+                    if (!c.shouldSkip() && isDue(c, update_index, d)) c.update(d);
+                }
+            }
+        });
     }
 
     void tick(const Seconds delta) override
     {
-        if constexpr (requires (C& c) { c.tick(delta); })
+        CGT_PROFILE_ZONE("tick", profilerTypeName<C>());
+        forEachChunk([this, delta](std::size_t first, std::size_t count, CommandBuffer& commands) {
+            if constexpr (requires (typename C::View v) { C::tickHot(delta, v); })
+            {
+                C::tickHot(delta, _hot.columns.view(first, count));
+            }
+            if constexpr (requires (C& c) { c.tick(delta, commands); })
+            {
+                for (C& c : components().subspan(first, count)) if (!c.shouldSkip()) c.tick(delta, commands);
+            }
+            else if constexpr (requires (C& c) { c.tick(delta); })
+            {
+                for (C& c : components().subspan(first, count)) if (!c.shouldSkip()) c.tick(delta);
+            }
+        });
+    }
+
+    //Called before every tick, on every manager, before any of them ticks
+    void beginTick() override
+    {
+        if constexpr (HasBeginTickPhase<C>)
         {
-            for (auto& c : _components) if (!c.shouldDestroy()) c.tick(delta);
+            for (auto& c : components()) c.beginTick();
         }
     }
 
     void draw(const glm::mat4& v, const glm::mat4& p) const override
     {
+        CGT_PROFILE_ZONE("draw", profilerTypeName<C>());
         if constexpr (requires (const C& c) { c.draw(v, p); })
         {
-            for (auto& c : _components) c.draw(v, p);
+            for (auto& c : components()) if (!c.shouldSkip()) c.draw(v, p);
         }
     }
 
     void drawGeometry(const glm::mat4& v, const glm::mat4& p) const override
     {
+        CGT_PROFILE_ZONE("drawGeometry", profilerTypeName<C>());
         if constexpr (requires (const C& c) { c.drawGeometry(v, p); })
         {
-            for (auto& c : _components) c.drawGeometry(v, p);
+            for (auto& c : components()) if (!c.shouldSkip()) c.drawGeometry(v, p);
         }
     }
 
     void cleanup(Seconds delta) override
     {
+        CGT_PROFILE_ZONE("cleanup", profilerTypeName<C>());
+        FrameArena::Scope arena_scope;
         using std::begin, std::end;
-        _components.erase(Utility::forEachRemovable(_components, [](C& c) {
-            if constexpr (requires (C& c) { c.stop(); }) if (c.shouldDestroy()) c.stop();
-            return c.shouldDestroy();
-        }), end(_components));
+        std::pmr::vector<C> moving(FrameArena::resource()); //Stored, of the entities released or acquired since the last cleanup
+        bool destroyed = _destroy_requested.exchange(false);
+        bool reordered = destroyed; //Otherwise the hot columns and the change blocks are still in order
+        if constexpr (SparseComponent<C>)
+        {
+            removeDestroyed();
+            reordered |= swapMisplaced(delta);
+        }
+        else
+        {
+            takeMisplaced(moving);
+            reordered |= !moving.empty();
+            //Each part on its own, so that the live one stays first. Skipped when only entities were released or acquired
+            if (destroyed)
+            {
+                std::size_t dormant_end = eraseDestroyed(_live, _components.size());
+                _components.erase(begin(_components) + dormant_end, end(_components));
+                std::size_t live_end = eraseDestroyed(0, _live);
+                _components.erase(begin(_components) + live_end, begin(_components) + _live);
+                _live = live_end;
+            }
+        }
 
-        auto list = std::move(_new_components);
-        for (C& c : list)
+        //New components are appended then merged in a single pass, rather than inserted one by one. Room for all of them
+        //is made upfront, growing geometrically as reserving exactly would reallocate at every small batch
+        auto blocks = std::move(_new_components);
+        reordered |= !blocks.empty();
+        std::size_t old_size = _components.size();
+        std::size_t needed = old_size + moving.size();
+        for (auto& block : blocks) needed += block.size();
+        if (needed > _components.capacity())
+        {
+            _components.reserve(std::max(needed, 2 * _components.capacity()));
+        }
+        //The components of released entities are held back, to be appended after the others
+        std::pmr::vector<C> dormant(FrameArena::resource());
+        for (auto& block : blocks) for (C& c : block)
         {
             if constexpr (requires (C& c) { c.start(); })
             {
@@ -85,30 +415,386 @@ public:
                 }
                 continue;
             }
-            auto it = _components.emplace(std::upper_bound(begin(_components), end(_components), &c.owner(), [](const Entity* l, const C& r) { return std::less<const Entity*>{}(l, &r.owner()); }), std::move(c));
-            if constexpr (requires (C& c) { c.update(delta); })
+            if (!SparseComponent<C> && !c.owner().active())
+            {
+                dormant.push_back(std::move(c));
+                continue;
+            }
+            updateAdded(_components.emplace_back(std::move(c)), delta);
+        }
+        for (C& c : moving)
+        {
+            if (c.shouldDestroy())
+            {
+                if constexpr (requires (C& c) { c.stop(); }) c.stop();
+                continue;
+            }
+            if (c.owner().active()) updateAdded(_components.emplace_back(std::move(c)), delta);
+            else dormant.push_back(std::move(c));
+        }
+        if constexpr (SparseComponent<C>)
+        {
+            //Appended after the dormant part, those of active entities are swapped to its front
+            for (std::size_t i = old_size; i < _components.size(); ++i)
+            {
+                if (!_components[i].owner().active()) continue;
+                if (i != _live) std::swap(_components[i], _components[_live]);
+                ++_live;
+            }
+        }
+        else if (std::size_t live_added = _components.size() - old_size; live_added + dormant.size() > 0)
+        {
+            //Live part, dormant part, then the added live and dormant components, each group sorted by owner. The added live
+            //ones are rotated in front of the dormant part and both parts merged with what was added to them
+            for (C& c : dormant) _components.emplace_back(std::move(c));
+            auto by_owner = [](const C& l, const C& r) { return std::less<const Entity*>{}(&l.owner(), &r.owner()); };
+            auto first = begin(_components);
+            auto live_added_end = first + old_size + live_added;
+            std::stable_sort(first + old_size, live_added_end, by_owner);
+            std::stable_sort(live_added_end, end(_components), by_owner);
+            std::rotate(first + _live, first + old_size, live_added_end);
+            std::size_t dormant_count = old_size - _live;
+            std::inplace_merge(first, first + _live, first + _live + live_added, by_owner);
+            _live += live_added;
+            std::inplace_merge(first + _live, first + _live + dormant_count, end(_components), by_owner);
+        }
+
+        if constexpr (SpatialComponent<C>)
+        {
+            if (std::exchange(_reorder_requested, false))
+            {
+                reorderSpatially();
+                reordered = true;
+            }
+        }
+        if (!reordered) return;
+
+        if constexpr (HasHotFields<C>)
+        {
+            //Bring the hot columns back in the order of _components, dropping the slots of the destroyed ones
+            _hot.order.clear();
+            for (C& c : _components) _hot.order.push_back(hotSlot(c));
+            _hot.columns.gather(_hot.order);
+            for (std::size_t i = 0; i < _components.size(); ++i) hotSlot(_components[i]) = i;
+        }
+
+        if constexpr (std::derived_from<C, ChangeTracked>)
+        {
+            ChangeBlocks& blocks = _changes.blocks;
+            blocks.first = _components.empty() ? 0 : reinterpret_cast<std::uintptr_t>(&_components.front()._changed_version);
+            blocks.stride = sizeof(C);
+            blocks.count = _live; //Those of released entities are ignored until acquired again
+            blocks.versions.assign((_live + ChangeBlocks::BlockSize - 1) / ChangeBlocks::BlockSize, 0);
+            for (std::size_t i = 0; i < _live; ++i)
             {
-                it->update(delta);
+                std::uint32_t& block = blocks.versions[i / ChangeBlocks::BlockSize];
+                block = std::max(block, _components[i].changedVersion());
             }
         }
     }
 
+    //Latest change version of each block of components, see ChangeBlocks
+    std::span<const std::uint32_t> changeBlocks() const requires std::derived_from<C, ChangeTracked>
+    {
+        return _changes.blocks.versions;
+    }
+
+    //Stops the started components, when the World is destroyed
+    void stopAll() override
+    {
+        if constexpr (requires (C& c) { c.stop(); })
+        {
+            for (auto& c : _components) c.stop();
+        }
+    }
+
+    //Calls the optional activate or deactivate of a component of this manager, when its entity is acquired from or released to an EntityPool
+    void activate(Component& c, bool active) override
+    {
+        _activated.emplace_back(c);
+        if constexpr (requires (C& c) { c.activate(); })
+        {
+            if (active) static_cast<C&>(c).activate();
+        }
+        if constexpr (requires (C& c) { c.deactivate(); })
+        {
+            if (!active) static_cast<C&>(c).deactivate();
+        }
+    }
+
+    //Makes room for count components to be built without allocating, in a block of their own if the last one is too full
+    void reserveNew(std::size_t count)
+    {
+        if (_new_components.empty() || _new_components.back().capacity() - _new_components.back().size() < count)
+        {
+            _new_components.emplace_back().reserve(std::max(count, NewBlockSize));
+        }
+    }
+
     template<typename... Args>
     C& build(Args&&... args)
     {
-        _new_components.emplace_front(std::forward<Args>(args)...);
-        return _new_components.front();
+        if (_new_components.empty() || _new_components.back().size() == _new_components.back().capacity()) reserveNew(1);
+        C& c = _new_components.back().emplace_back(std::forward<Args>(args)...);
+        c._type = componentTypeId<C>();
+        if constexpr (std::derived_from<C, Throttled>)
+        {
+            c._phase = _throttle_phase++;
+        }
+        if constexpr (HasHotFields<C>)
+        {
+            static_cast<typename C::HotFieldsType&>(c).attach(_hot.columns);
+        }
+        if constexpr (std::derived_from<C, ChangeTracked>)
+        {
+            c._blocks = &_changes.blocks;
+        }
+        return c;
     }
 
+    //Those of the entities released to an EntityPool are left out once cleaned up
+    std::span<C> components() { return std::span(_components).first(_live); }
+    std::span<const C> components() const { return std::span(_components).first(_live); }
+
     auto begin() { return _components.begin(); }
     auto begin() const { return _components.begin(); }
     auto cbegin() const { return _components.cbegin(); }
-    auto end() { return _components.end(); }
-    auto end() const { return _components.end(); }
-    auto cend() const { return _components.cend(); }
+    auto end() { return _components.begin() + _live; }
+    auto end() const { return _components.begin() + _live; }
+    auto cend() const { return _components.cbegin() + _live; }
 private:
-    std::vector<C> _components;
-    std::forward_list<C> _new_components; //Needed to guarantee reference and pointer validity within a single update
+    static_assert(!(ParallelComponent<C> && ExclusiveComponent<C>), "A component type cannot be both parallel and exclusive");
+    static_assert(!(SparseComponent<C> && HasHotFields<C>), "Sparse storage does not support HotFields");
+    static_assert(!SpatialComponent<C> || requires (const C& c) { { c.spatialPosition() } -> std::convertible_to<glm::vec3>; },
+        "Spatial storage needs glm::vec3 spatialPosition() const");
+
+    //Swap removes the reported components, without visiting the others
+    void removeDestroyed()
+    {
+        {
+            std::scoped_lock lock(_destroyed_mutex);
+            _removing.swap(_destroyed);
+        }
+        for (WeakRef<Component>& ref : _removing)
+        {
+            //Duplicates are already gone, and the new components are dropped when merged in
+            C* c = stored(ref);
+            if (!c || !c->shouldDestroy()) continue;
+
+            if constexpr (requires (C& c) { c.stop(); }) c->stop();
+            //A live one is replaced by the last live one, itself replaced by the last one
+            std::size_t i = c - _components.data();
+            if (i < _live)
+            {
+                --_live;
+                if (i != _live) _components[i] = std::move(_components[_live]);
+                i = _live;
+            }
+            if (i != _components.size() - 1) _components[i] = std::move(_components.back());
+            _components.pop_back();
+        }
+        _removing.clear();
+    }
+
+    //Swaps the stored components of the entities released or acquired since the last cleanup across the end of the live part.
+    //Returns whether any was. Those moved to the live part get the update they missed
+    bool swapMisplaced(Seconds delta)
+    {
+        bool swapped = false;
+        for (WeakRef<Component>& ref : _activated)
+        {
+            C* c = stored(ref);
+            if (!c) continue;
+            std::size_t i = c - _components.data();
+            if (i < _live && !c->owner().active())
+            {
+                --_live;
+                if (i != _live) std::swap(_components[i], _components[_live]);
+                swapped = true;
+            }
+            else if (i >= _live && c->owner().active())
+            {
+                if (i != _live) std::swap(_components[i], _components[_live]);
+                updateAdded(_components[_live++], delta);
+                swapped = true;
+            }
+        }
+        _activated.clear();
+        return swapped;
+    }
+
+    //Added to the live part by a cleanup, so missed by the update phase before it
+    void updateAdded(C& c, Seconds delta)
+    {
+        if constexpr (requires (typename C::View v) { C::updateHot(delta, v); })
+        {
+            C::updateHot(delta, _hot.columns.view(hotSlot(c), 1));
+        }
+        if constexpr (requires (C& c) { c.update(delta); })
+        {
+            if (!c.shouldSkip()) c.update(delta);
+        }
+    }
+
+    //Moves out, in storage order, the stored components of the entities released or acquired since the last cleanup that
+    //are in the wrong part, and closes the gaps
+    void takeMisplaced(std::pmr::vector<C>& moving)
+    {
+        std::pmr::vector<std::size_t> misplaced(FrameArena::resource());
+        for (WeakRef<Component>& ref : _activated)
+        {
+            C* c = stored(ref);
+            if (!c) continue;
+            std::size_t i = c - _components.data();
+            if ((i < _live) != c->owner().active()) misplaced.push_back(i);
+        }
+        _activated.clear();
+        if (misplaced.empty()) return;
+
+        std::sort(misplaced.begin(), misplaced.end());
+        misplaced.erase(std::unique(misplaced.begin(), misplaced.end()), misplaced.end());
+        std::size_t write = misplaced.front();
+        for (std::size_t read = write, next = 0; read < _components.size(); ++read)
+        {
+            if (next < misplaced.size() && misplaced[next] == read)
+            {
+                moving.push_back(std::move(_components[read]));
+                ++next;
+            }
+            else if (write++ != read) _components[write - 1] = std::move(_components[read]);
+        }
+        _live -= std::lower_bound(misplaced.begin(), misplaced.end(), _live) - misplaced.begin();
+        _components.erase(_components.begin() + write, _components.end());
+    }
+
+    //Removes the destroyed components of [first, last), keeping the order of the others, and returns the end of those kept
+    std::size_t eraseDestroyed(std::size_t first, std::size_t last)
+    {
+        std::span<C> range = std::span(_components).subspan(first, last - first);
+        auto kept = Utility::forEachRemovable(range, [](C& c) {
+            if constexpr (requires (C& c) { c.stop(); }) if (c.shouldDestroy()) c.stop();
+            return c.shouldDestroy();
+        });
+        return first + (kept - range.begin());
+    }
+
+    //nullptr unless the component is in _components
+    C* stored(const WeakRef<Component>& ref)
+    {
+        C* c = static_cast<C*>(ref.ptr());
+        std::less<const C*> less;
+        return c && !less(c, _components.data()) && less(c, _components.data() + _components.size()) ? c : nullptr;
+    }
+
+    //Sorts the components by the Morton code of their position within the bounds of all of them, then moves them in place
+    void reorderSpatially()
+    {
+        CGT_PROFILE_ZONE("reorderSpatially", profilerTypeName<C>());
+        std::size_t count = _live;
+        if (count < 2) return;
+
+        std::pmr::vector<glm::vec3> positions(FrameArena::resource());
+        positions.reserve(count);
+        glm::vec3 low(std::numeric_limits<float>::max());
+        glm::vec3 high(std::numeric_limits<float>::lowest());
+        for (const C& c : components())
+        {
+            glm::vec3 p = c.spatialPosition();
+            positions.push_back(p);
+            low = glm::min(low, p);
+            high = glm::max(high, p);
+        }
+
+        constexpr float cells = (1 << 21) - 1;
+        glm::vec3 scale = cells / glm::max(high - low, glm::vec3(std::numeric_limits<float>::min()));
+        std::pmr::vector<std::pair<std::uint64_t, std::size_t>> keys(FrameArena::resource());
+        keys.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            glm::vec3 q = glm::clamp((positions[i] - low) * scale, glm::vec3(0), glm::vec3(cells));
+            keys.emplace_back(impl::mortonCode(static_cast<std::uint32_t>(q.x), static_cast<std::uint32_t>(q.y), static_cast<std::uint32_t>(q.z)), i);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        //keys[i].second is the component going to i. Each cycle of the permutation costs one move per component plus a temporary
+        for (std::size_t start = 0; start < count; ++start)
+        {
+            if (keys[start].second == start) continue;
+            C moved = std::move(_components[start]);
+            std::size_t current = start;
+            while (true)
+            {
+                std::size_t next = std::exchange(keys[current].second, current);
+                if (next == start)
+                {
+                    _components[current] = std::move(moved);
+                    break;
+                }
+                _components[current] = std::move(_components[next]);
+                current = next;
+            }
+        }
+    }
+
+    //Calls func(first, count, commands) on consecutive chunks of the components. ParallelComponent types are split in about four
+    //chunks per thread, for the work stealing to even out their costs, other types run in a single chunk
+    template<typename F>
+    void forEachChunk(F&& func)
+    {
+        FrameArena::Scope arena_scope;
+        std::size_t count = _live;
+        if (count == 0) return;
+
+        std::size_t chunk_size = count;
+        if constexpr (ParallelComponent<C>)
+        {
+            std::size_t chunks_wanted = 4 * (WorkerPool::instance().workerCount() + 1);
+            chunk_size = std::max(MinParallelChunk, (count + chunks_wanted - 1) / chunks_wanted);
+        }
+        std::size_t chunks = (count + chunk_size - 1) / chunk_size;
+        if (_chunk_commands.size() < chunks) _chunk_commands.resize(chunks);
+
+        if (chunks == 1)
+        {
+            func(0, count, _chunk_commands[0]);
+        }
+        else
+        {
+            WorkerPool::instance().parallelFor(chunks, [&](std::size_t i) {
+                FrameArena::Scope chunk_scope;
+                std::size_t first = i * chunk_size;
+                func(first, std::min(chunk_size, count - first), _chunk_commands[i]);
+            });
+        }
+        for (std::size_t i = 0; i < chunks; ++i) if (!_chunk_commands[i].empty()) submitCommands(_chunk_commands[i]);
+    }
+
+    //Whether c updates at this update, delta becoming the time it updates by. Always for the types not Throttled
+    static bool isDue(C& c, std::uint32_t update_index, Seconds& delta)
+    {
+        if constexpr (std::derived_from<C, Throttled>)
+        {
+            return c.due(update_index, c.owner().updatePeriod(), delta);
+        }
+        else return true;
+    }
+
+    static std::size_t& hotSlot(C& c) requires HasHotFields<C>
+    {
+        return static_cast<typename C::HotFieldsType&>(c)._slot;
+    }
+
+    std::pmr::vector<C> _components; //Those of active entities first, the _live first ones, then those released to an EntityPool
+    std::size_t _live = 0;
+    std::pmr::vector<WeakRef<Component>> _activated; //Reported by activate since the last cleanup, may hold duplicates
+    static constexpr std::size_t NewBlockSize = 64;
+    std::pmr::vector<std::pmr::vector<C>> _new_components; //Blocks that are never grown, for reference and pointer validity within a single update
+    std::pmr::vector<CommandBuffer> _chunk_commands; //Reused, one per chunk of the last update or tick
+    std::pmr::vector<WeakRef<Component>> _removing; //Reused, the reports taken from _destroyed by the last cleanup
+    [[no_unique_address]] HotStorage<C> _hot; //Hot fields of the components, in the same order as _components once cleaned up
+    [[no_unique_address]] ChangeStorage<C> _changes;
+    std::uint32_t _update_count = 0; //Updates run, to find the Throttled components due
+    std::uint32_t _throttle_phase = 0; //Given to the next Throttled component built, spreading them over the updates of their bucket
 };
 
 #endif
@@ -1,19 +1,48 @@
 #include "Entity.h"
 #include "Component.h"
+#include "EntityPool.h"
 
 Entity::Entity(World& w)
-    :_world(&w)
+    :WeakReferencable(w._handles), _world(&w), _components(w._resource)
 {
 }
 Entity::~Entity() = default;
 
 void Entity::destroy()
 {
-    _marked_for_destroy = true;
-    world()._should_cleanup = true;
+    if (_marked_for_destroy.exchange(true)) return;
+    for (auto& slot : _components) world().requestCleanup(slot.type, slot.ref.ptr());
+    std::scoped_lock lock(world()._destroyed_mutex);
+    world()._destroyed_entities.push_back(this);
+}
+
+void Entity::release()
+{
+    if (EntityPool* pool = _pool.ptr()) pool->release(*this);
+    else destroy();
+}
+
+bool Entity::active() const
+{
+    return _active;
 }
 
 World& Entity::world() const
 {
     return *_world;
 }
+
+std::uint8_t Entity::updateBucket() const
+{
+    return _update_bucket.load(std::memory_order_relaxed);
+}
+
+void Entity::updateBucket(std::uint8_t bucket)
+{
+    _update_bucket.store(std::min(bucket, MaxUpdateBucket), std::memory_order_relaxed);
+}
+
+unsigned Entity::updatePeriod() const
+{
+    return 1u << updateBucket();
+}
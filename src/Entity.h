@@ -3,12 +3,14 @@
 
 #include "WeakRef.hpp"
 #include "World.h"
-#include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <concepts>
-#include <typeinfo>
-#include <typeindex>
+#include <cstdint>
+#include <atomic>
 
 class Component;
+class EntityPool;
 struct EntityKey
 {
     friend class Entity;
@@ -23,28 +25,38 @@ class Entity : public WeakReferencable
 {
     friend class World;
     friend class Component;
+    friend class EntityPool;
 public:
     Entity(const Entity&) = delete;
     Entity(Entity&&) = delete;
     ~Entity();
 
     void destroy();
+    //Gives the entity back to the EntityPool it was acquired from, or destroys it if it has none. Not thread safe
+    void release();
+    //False while released to an EntityPool, the phases and the Physics queries then skip its components
+    bool active() const;
 
     template<std::derived_from<Component> T, typename... Args>
     T& buildComponent(Args&&... args)
     {
         T& ref = _world->buildComponent<T>(EntityKey{ this }, std::forward<Args>(args)...);
-        _components.emplace(typeid(T), ref);
+        ComponentTypeId type = componentTypeId<T>();
+        _components.insert(upperBound(type), { type, ref });
+        _component_mask |= maskBit(type);
         return ref;
     }
 
     template<std::derived_from<Component> T>
     T* findComponent() const
     {
-        auto [it, sentinel] = _components.equal_range(typeid(T));
-        while (it != sentinel)
+        ComponentTypeId type = componentTypeId<T>();
+        if (!(_component_mask & maskBit(type))) return nullptr;
+
+        auto it = lowerBound(type);
+        while (it != _components.end() && it->type == type)
         {
-            if (it->second) return static_cast<T*>(it->second.ptr());
+            if (Component* c = it->ref.ptr()) return static_cast<T*>(c);
             it = _components.erase(it);
         }
         return nullptr;
@@ -58,12 +70,43 @@ public:
     }
 
     World& world() const;
+
+    //The Throttled components of the entity update once every 2^bucket updates, see Throttled. Thread safe
+    static constexpr std::uint8_t MaxUpdateBucket = 7;
+    std::uint8_t updateBucket() const;
+    void updateBucket(std::uint8_t bucket); //Clamped to MaxUpdateBucket
+    unsigned updatePeriod() const; //2^updateBucket()
 private:
     Entity(World&);
 
+    struct ComponentSlot
+    {
+        ComponentTypeId type;
+        WeakRef<Component> ref;
+    };
+
+    static std::uint64_t maskBit(ComponentTypeId type)
+    {
+        return std::uint64_t{ 1 } << (type % 64);
+    }
+
+    auto lowerBound(ComponentTypeId type) const
+    {
+        return std::lower_bound(_components.begin(), _components.end(), type, [](const ComponentSlot& s, ComponentTypeId t) { return s.type < t; });
+    }
+
+    auto upperBound(ComponentTypeId type) const
+    {
+        return std::upper_bound(_components.begin(), _components.end(), type, [](ComponentTypeId t, const ComponentSlot& s) { return t < s.type; });
+    }
+
     World* _world;
-    mutable std::unordered_multimap<std::type_index, WeakRef<Component>> _components;
-    bool _marked_for_destroy = false;
+    mutable std::pmr::vector<ComponentSlot> _components; //Sorted by type, components of the same type in build order. Destroyed ones are dropped lazily
+    std::uint64_t _component_mask = 0; //Bit type % 64 is set if a component of that type may be present, so that most misses skip the search
+    std::atomic<bool> _marked_for_destroy = false; //May be set from concurrently running managers
+    std::atomic<std::uint8_t> _update_bucket = 0;
+    bool _active = true; //Only changed by World::activate
+    WeakRef<EntityPool> _pool; //Null unless acquired from a pool
 };
 
 #endif
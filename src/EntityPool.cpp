@@ -0,0 +1,56 @@
+#include "EntityPool.h"
+#include <stdexcept>
+
+EntityPool::EntityPool(World& world, Prefab prefab)
+    : WeakReferencable(world._handles), _world(&world), _prefab(std::move(prefab))
+{
+}
+
+Entity& EntityPool::acquire()
+{
+    while (!_released.empty())
+    {
+        Entity* e = _released.back().ptr();
+        _released.pop_back();
+        if (!e || e->_marked_for_destroy) continue;
+
+        _world->activate(*e, true);
+        return *e;
+    }
+
+    Entity& e = _world->instantiate(_prefab);
+    e._pool = *this;
+    return e;
+}
+
+void EntityPool::release(Entity& e)
+{
+    if (e._pool.ptr() != this) throw std::runtime_error("Entity not acquired from this pool");
+    if (!e._active) return;
+
+    _world->activate(e, false);
+    _released.emplace_back(e);
+}
+
+void EntityPool::reserve(std::size_t count)
+{
+    _released.reserve(_released.size() + count);
+    _world->instantiate(_prefab, count, [this](Entity& e, std::size_t) {
+        e._pool = *this;
+        release(e);
+    });
+}
+
+void EntityPool::clear()
+{
+    for (auto& ref : _released)
+    {
+        if (Entity* e = ref.ptr()) e->destroy();
+    }
+    _released.clear();
+}
+
+std::size_t EntityPool::available() const
+{
+    return _released.size();
+}
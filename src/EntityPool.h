@@ -0,0 +1,55 @@
+#ifndef CGT_ENTITYPOOL_H
+#define CGT_ENTITYPOOL_H
+
+#include "World.h"
+#include "Entity.h"
+#include "Prefab.hpp"
+#include "WeakRef.hpp"
+#include <vector>
+#include <concepts>
+#include <cstddef>
+
+//Entities built from a prefab, kept when released and reused by acquire rather than destroyed and built again.
+//A released entity is inactive: its components are neither stopped nor destroyed, and the phases skip them. The next
+//cleanup moves them to a dormant part at the end of the storage of each manager, out of view, query, getAll and the hot
+//passes, so that a large pool costs nothing to the live entities. Acquiring moves them back at the next cleanup, which
+//gives them the update they missed, as to new components.
+//Component types with state to put back when reused provide "void activate()", called by acquire before the initializer,
+//and those holding on to something while unused, like a registration to Physics, "void deactivate()", called by release.
+//Released entities keep their event listeners and behaviours. A WeakRef kept past release refers to the entity once
+//acquired again. Not thread safe, release from a parallel update through a CommandBuffer.
+//Movable, the entities follow the pool. Destroying the pool leaves the entities it holds in the World, see clear
+class EntityPool : public WeakReferencable
+{
+public:
+    //The World must outlive the pool
+    EntityPool(World& world, Prefab prefab);
+    EntityPool(EntityPool&&) = default;
+    EntityPool& operator=(EntityPool&&) = default;
+
+    //A released entity reactivated, or a new one built from the prefab if there is none, then initializer(entity)
+    template<std::invocable<Entity&> F>
+    Entity& acquire(F&& initializer)
+    {
+        Entity& e = acquire();
+        initializer(e);
+        return e;
+    }
+    Entity& acquire();
+
+    //Deactivates the entity and keeps it for the next acquire. Usually called through Entity::release
+    void release(Entity& e);
+
+    //Builds count inactive entities upfront, so that as many acquire do not build any
+    void reserve(std::size_t count);
+    //Destroys the released entities
+    void clear();
+
+    std::size_t available() const; //Released entities, some of which may have been destroyed since
+private:
+    World* _world;
+    Prefab _prefab;
+    std::vector<WeakRef<Entity>> _released; //The most recently released are reused first, their components are more likely in cache
+};
+
+#endif
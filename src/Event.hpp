@@ -3,36 +3,48 @@
 
 #include <vector>
 #include <utility>
+#include <tuple>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include "WeakRef.hpp"
 #include "Utility.h"
 
 template<typename... Args>
 struct Event
 {
-private:
+protected:
     friend struct HasEvents;
     typedef void (WeakReferencable::*Fptr)(Args...);
 public:
     template<typename T>
     void add(T& target, void (T::*mf)(Args...))
     {
-        _callables.emplace_back(target, static_cast<Fptr>(mf));
+        _callables.push_back({ target, static_cast<Fptr>(mf), false });
+    }
+
+    //Removed once called
+    template<typename T>
+    void addOnce(T& target, void (T::*mf)(Args...))
+    {
+        _callables.push_back({ target, static_cast<Fptr>(mf), true });
     }
 
     template<typename T>
     void remove(T& target)
     {
         WeakRef<WeakReferencable> wr = target;
-        std::erase_if(_callables, [&wr](auto& p) { return !p.first || p.first == wr; });
+        std::erase_if(_callables, [&wr](auto& l) { return !l.target || l.target == wr; });
     }
 
     template<typename... CallArgs>
     void trigger(CallArgs&&... args)
     {
-        _callables.erase(Utility::forEachRemovable(_callables, [&](auto& p) {
-            if (!p.first) return true;
-            (p.first->*p.second)(args...); //No forward as the elements may be shared by multiple functions and should not be moved
-            return false;
+        _callables.erase(Utility::forEachRemovable(_callables, [&](auto& l) {
+            if (!l.target) return true;
+            (l.target->*l.function)(args...); //No forward as the elements may be shared by multiple functions and should not be moved
+            return l.once;
             }), end(_callables));
     }
 
@@ -42,8 +54,152 @@ public:
         trigger(std::forward<CallArgs>(args)...);
     }
 
+protected:
+    struct Listener
+    {
+        WeakRef<WeakReferencable> target;
+        Fptr function;
+        bool once;
+    };
+
+    std::vector<Listener> _callables;
+};
+
+class World;
+
+//Type erased part of QueuedEvent, through which a World dispatches it
+class QueuedEventBase
+{
+    friend class World;
+public:
+    QueuedEventBase() = default;
+    QueuedEventBase(const QueuedEventBase&) = delete;
+    QueuedEventBase& operator=(const QueuedEventBase&) = delete;
+
+protected:
+    ~QueuedEventBase(); //Removes the event from its World, defined in World.cpp
+    virtual void dispatch() = 0;
+
+private:
+    World* _world = nullptr;
+};
+
+//Event whose payloads may also be posted from any thread, without locks, into a queue of its own. They are delivered
+//in batches by the World the event is added to, see World::addQueuedEvent, in posting order for each thread.
+//A batch goes to the listeners registered when it starts, except those destroyed since.
+//Queue nodes are recycled: a dispatch hands its batch back to the event, from which a posting thread takes all of them at
+//once into a cache of its own. Steady state posting does not allocate
+template<typename... Args>
+class QueuedEvent : public Event<Args...>, public QueuedEventBase
+{
+public:
+    QueuedEvent() = default;
+    ~QueuedEvent()
+    {
+        deleteNodes(_head.exchange(nullptr, std::memory_order_acquire));
+        deleteNodes(_recycled.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    template<typename... CallArgs>
+    void post(CallArgs&&... args)
+    {
+        Node* node = allocate();
+        node->payload.emplace(std::forward<CallArgs>(args)...);
+        node->next = _head.load(std::memory_order_relaxed);
+        while (!_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
 private:
-    std::vector<std::pair<WeakRef<WeakReferencable>, Fptr>> _callables;
+    struct Node
+    {
+        std::optional<std::tuple<std::decay_t<Args>...>> payload; //Empty while recycled
+        Node* next;
+    };
+
+    //Recycled nodes of the calling thread, shared by the events of the same type
+    struct NodeCache
+    {
+        Node* head = nullptr;
+        ~NodeCache() { deleteNodes(head); }
+    };
+
+    static NodeCache& cache()
+    {
+        thread_local NodeCache c;
+        return c;
+    }
+
+    Node* allocate()
+    {
+        NodeCache& c = cache();
+        if (!c.head) c.head = _recycled.exchange(nullptr, std::memory_order_acquire);
+        if (!c.head) return new Node{};
+        return std::exchange(c.head, c.head->next);
+    }
+
+    //Gives back a chain of delivered nodes, from first to last
+    void recycle(Node* first, Node* last)
+    {
+        last->next = _recycled.load(std::memory_order_relaxed);
+        while (!_recycled.compare_exchange_weak(last->next, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    //Payloads posted during the dispatch wait for the next one
+    void dispatch() override
+    {
+        Node* node = _head.exchange(nullptr, std::memory_order_acquire);
+        if (!node) return;
+
+        //The queue is pushed as a stack, reversed to deliver in posting order
+        Node* const last = node;
+        Node* ordered = nullptr;
+        while (node)
+        {
+            Node* next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+        Node* const first = ordered;
+
+        //Listeners added once only get the first payload of the batch
+        _listeners.assign(this->_callables.begin(), this->_callables.end());
+        std::erase_if(this->_callables, [](auto& l) { return !l.target || l.once; });
+        try
+        {
+            for (; ordered; ordered = ordered->next)
+            {
+                for (auto& l : _listeners)
+                {
+                    if (WeakReferencable* target = l.target.ptr())
+                    {
+                        std::apply([&](auto&... args) { (target->*l.function)(args...); }, *ordered->payload);
+                        if (l.once) l.target = nullptr;
+                    }
+                }
+                ordered->payload.reset();
+            }
+        }
+        catch (...)
+        {
+            //The payloads not delivered yet are dropped with the rest of the batch
+            for (; ordered; ordered = ordered->next) ordered->payload.reset();
+            _listeners.clear();
+            recycle(first, last);
+            throw;
+        }
+        _listeners.clear();
+        recycle(first, last);
+    }
+
+    static void deleteNodes(Node* node)
+    {
+        while (node) delete std::exchange(node, node->next);
+    }
+
+    std::atomic<Node*> _head = nullptr; //Most recently posted first
+    std::atomic<Node*> _recycled = nullptr; //Delivered nodes, taken all at once by a posting thread
+    std::vector<typename Event<Args...>::Listener> _listeners; //Kept to reuse its storage
 };
 
 template<typename T, typename... Args>
@@ -51,6 +207,7 @@ struct PrivateEvent : private Event<Args...>
 {
     friend T;
     using Event<Args...>::add;
+    using Event<Args...>::addOnce;
     using Event<Args...>::remove;
 };
 
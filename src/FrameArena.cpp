@@ -0,0 +1,89 @@
+#include "FrameArena.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+namespace
+{
+    class Arena final : public std::pmr::memory_resource
+    {
+    public:
+        static constexpr std::size_t InitialBlockSize = 64 * 1024;
+
+        std::size_t block = 0; //Allocations go to _blocks[block] from offset
+        std::size_t offset = 0;
+        unsigned depth = 0; //Open scopes
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<std::byte[]> data;
+            std::size_t size;
+        };
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            while (block < _blocks.size())
+            {
+                Block& b = _blocks[block];
+                void* p = b.data.get() + offset;
+                std::size_t space = b.size - offset;
+                if (std::align(alignment, bytes, p, space))
+                {
+                    offset = b.size - space + bytes;
+                    return p;
+                }
+                ++block;
+                offset = 0;
+            }
+
+            std::size_t size = std::max({ InitialBlockSize, bytes + alignment, _blocks.empty() ? 0 : 2 * _blocks.back().size });
+            _blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+            block = _blocks.size() - 1;
+            offset = 0;
+            return do_allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void*, std::size_t, std::size_t) override
+        {
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        std::vector<Block> _blocks; //Kept until the thread exits
+    };
+
+    Arena& arena()
+    {
+        thread_local Arena a;
+        return a;
+    }
+}
+
+namespace FrameArena
+{
+    std::pmr::memory_resource* resource()
+    {
+        Arena& a = arena();
+        return a.depth > 0 ? &a : std::pmr::get_default_resource();
+    }
+
+    Scope::Scope()
+    {
+        Arena& a = arena();
+        _block = a.block;
+        _offset = a.offset;
+        ++a.depth;
+    }
+
+    Scope::~Scope()
+    {
+        Arena& a = arena();
+        a.block = _block;
+        a.offset = _offset;
+        --a.depth;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef CGT_FRAMEARENA_H
+#define CGT_FRAMEARENA_H
+
+#include <memory_resource>
+#include <cstddef>
+
+//Bump allocator per thread for the temporaries of the hot paths. Memory allocated while a Scope is open is given back
+//all at once when it closes, and its blocks are reused, so that steady state updates and ticks do not touch the heap.
+//The managers open a Scope around the update, tick and cleanup of their components, temporaries must not outlive them.
+namespace FrameArena
+{
+    //The arena of the calling thread while a Scope is open on it, the default resource otherwise
+    std::pmr::memory_resource* resource();
+
+    class Scope
+    {
+    public:
+        Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope();
+
+    private:
+        std::size_t _block;
+        std::size_t _offset;
+    };
+}
+
+#endif
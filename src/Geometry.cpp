@@ -63,9 +63,9 @@ bool intersect(const Capsule& l, const Capsule& r)
     if (length2(orthogonal_vec) == 0)
     {
         //float cla = projectionCoord(l.segment.a - l.segment.a, l_segment_vec);
-        const float cla = 0;
+        [[maybe_unused]] const float cla = 0;
         //float clb = projectionCoord(l_segment_vec, l_segment_vec);
-        const float clb = 1;
+        [[maybe_unused]] const float clb = 1;
         float cra = projectionCoord(r.segment.a - l.segment.a, l_segment_vec);
         float crb = projectionCoord(r.segment.b - l.segment.a, l_segment_vec);
         if (cra < 0 || crb < 0)
@@ -0,0 +1,145 @@
+#ifndef CGT_HOTFIELDS_HPP
+#define CGT_HOTFIELDS_HPP
+
+#include <vector>
+#include <memory_resource>
+#include <tuple>
+#include <span>
+#include <utility>
+#include <cstddef>
+
+//Contiguous slice of the hot columns of a component type, handed to its static updateHot/tickHot passes
+template<typename... Fields>
+class HotView
+{
+public:
+    explicit HotView(std::tuple<std::span<Fields>...> columns)
+        : _columns(columns)
+    {
+    }
+
+    template<std::size_t I>
+    auto column() const
+    {
+        return std::get<I>(_columns);
+    }
+
+    std::size_t size() const
+    {
+        return std::get<0>(_columns).size();
+    }
+
+private:
+    std::tuple<std::span<Fields>...> _columns;
+};
+
+//Structure of arrays storage for the hot fields of every component of a type, kept in the same order as the components
+template<typename... Fields>
+class HotColumns
+{
+public:
+    explicit HotColumns(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _columns(std::pmr::vector<Fields>(resource)...), _scratch(std::pmr::vector<Fields>(resource)...)
+    {
+    }
+
+    std::size_t push(std::tuple<Fields...>&& values)
+    {
+        std::apply([this](auto&&... v) {
+            std::apply([&](auto&... column) { (column.push_back(std::move(v)), ...); }, _columns);
+        }, std::move(values));
+        return std::get<0>(_columns).size() - 1;
+    }
+
+    HotView<Fields...> view(std::size_t first, std::size_t count)
+    {
+        return HotView<Fields...>{ std::apply([&](auto&... column) {
+            return std::tuple<std::span<Fields>...>{ std::span<Fields>(column.data() + first, count)... };
+        }, _columns) };
+    }
+
+    void reserve(std::size_t count)
+    {
+        std::apply([count](auto&... column) { (column.reserve(count), ...); }, _columns);
+    }
+
+    template<std::size_t I>
+    auto& at(std::size_t slot)
+    {
+        return std::get<I>(_columns)[slot];
+    }
+
+    //Rebuilds the columns so that the new slot i holds what was in old_slots[i]. Slots not listed are dropped
+    template<typename R>
+    void gather(const R& old_slots)
+    {
+        gatherColumns(old_slots, std::index_sequence_for<Fields...>{});
+    }
+
+private:
+    template<typename R, std::size_t... Is>
+    void gatherColumns(const R& old_slots, std::index_sequence<Is...>)
+    {
+        (gatherColumn<Is>(old_slots), ...);
+    }
+
+    template<std::size_t I, typename R>
+    void gatherColumn(const R& old_slots)
+    {
+        auto& column = std::get<I>(_columns);
+        auto& scratch = std::get<I>(_scratch);
+        scratch.clear();
+        scratch.reserve(old_slots.size());
+        for (std::size_t slot : old_slots) scratch.push_back(std::move(column[slot]));
+        swap(column, scratch);
+    }
+
+    std::tuple<std::pmr::vector<Fields>...> _columns;
+    std::tuple<std::pmr::vector<Fields>...> _scratch; //Kept around so that gathering does not reallocate every cleanup
+};
+
+//Opt-in base for components whose hot fields should be streamed through contiguous memory.
+//The fields live in the ComponentManager and are accessed through hot<I>(). The initial values are held in the
+//component until the manager attaches it, so they may be read and written from the constructor.
+//References returned by hot() are invalidated when another component of the same type is built.
+template<typename... Fields>
+class HotFields
+{
+    template<typename C>
+    friend class ComponentManager;
+public:
+    using HotFieldsType = HotFields;
+    using Columns = HotColumns<Fields...>;
+    using View = HotView<Fields...>;
+
+protected:
+    HotFields(Fields... initial)
+        : _pending{ std::move(initial)... }
+    {
+    }
+
+    template<std::size_t I>
+    auto& hot()
+    {
+        return _columns ? _columns->template at<I>(_slot) : std::get<I>(_pending);
+    }
+
+    template<std::size_t I>
+    const auto& hot() const
+    {
+        return const_cast<HotFields*>(this)->hot<I>();
+    }
+
+private:
+    void attach(Columns& columns)
+    {
+        _slot = columns.push(std::move(_pending));
+        _columns = &columns;
+    }
+
+    Columns* _columns = nullptr;
+    std::size_t _slot = 0;
+    std::tuple<Fields...> _pending;
+};
+
+#endif
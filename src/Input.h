@@ -84,10 +84,11 @@ private:
 
 class Inputs
 {
-    friend class World;
 public:
     static Inputs& instance();
 
+    void update(); //Polls every input, once per frame before World::update
+
     Input<bool> forward{ KeyPoller{GLFW_KEY_W} };
     Input<bool> backward{ KeyPoller{GLFW_KEY_S} };
     Input<bool> left{ KeyPoller{GLFW_KEY_A} };
@@ -95,8 +96,6 @@ public:
     Input<bool> attack{ MouseButtonPoller{GLFW_MOUSE_BUTTON_LEFT} };
 
     Input<glm::vec2> look{ MousePoller{} };
-private:
-    void update();
 };
 
 #endif
@@ -0,0 +1,234 @@
+#include "Jobs.h"
+#include "FrameArena.h"
+#include <algorithm>
+#include <memory_resource>
+
+void TaskGraph::clear()
+{
+    _successors.clear();
+    _predecessor_counts.clear();
+}
+
+std::size_t TaskGraph::add()
+{
+    _successors.emplace_back();
+    _predecessor_counts.push_back(0);
+    return _successors.size() - 1;
+}
+
+void TaskGraph::precede(std::size_t before, std::size_t after)
+{
+    _successors[before].push_back(after);
+    ++_predecessor_counts[after];
+}
+
+std::size_t TaskGraph::size() const
+{
+    return _successors.size();
+}
+
+const std::vector<std::size_t>& TaskGraph::successors(std::size_t task) const
+{
+    return _successors[task];
+}
+
+std::size_t TaskGraph::predecessorCount(std::size_t task) const
+{
+    return _predecessor_counts[task];
+}
+
+
+
+WorkerPool& WorkerPool::instance()
+{
+    static WorkerPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+namespace
+{
+    //Index of the queue of the worker thread running, in the pool it belongs to
+    thread_local const WorkerPool* current_pool = nullptr;
+    thread_local std::size_t current_queue = 0;
+}
+
+WorkerPool::WorkerPool(unsigned worker_count)
+{
+    for (unsigned i = 0; i <= worker_count; ++i) _queues.push_back(std::make_unique<Queue>());
+    _workers.reserve(worker_count);
+    for (unsigned i = 0; i < worker_count; ++i)
+    {
+        _workers.emplace_back([this, i](std::stop_token stop) { workerLoop(stop, i); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    for (auto& w : _workers) w.request_stop();
+    _sleep_cv.notify_all();
+}
+
+unsigned WorkerPool::workerCount() const
+{
+    return static_cast<unsigned>(_workers.size());
+}
+
+void WorkerPool::run(const TaskGraph& graph, const std::function<void(std::size_t)>& func)
+{
+    if (graph.size() == 0) return;
+
+    FrameArena::Scope arena_scope;
+    struct GraphRun
+    {
+        WorkerPool& pool;
+        const TaskGraph& graph;
+        const std::function<void(std::size_t)>& func;
+        std::pmr::vector<std::atomic<std::size_t>> remaining_predecessors;
+        Batch batch;
+    } state{ *this, graph, func, std::pmr::vector<std::atomic<std::size_t>>(graph.size(), FrameArena::resource()), {} };
+
+    //The successors are released even when the task throws, so that the rest of the graph still runs
+    state.batch.invoke = [](const void* context, std::size_t task) {
+        auto& s = *static_cast<GraphRun*>(const_cast<void*>(context));
+        std::exception_ptr exception;
+        try
+        {
+            s.func(task);
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+        for (std::size_t next : s.graph.successors(task))
+        {
+            if (s.remaining_predecessors[next].fetch_sub(1, std::memory_order_acq_rel) == 1) s.pool.push(s.batch, next, 1);
+        }
+        if (exception) std::rethrow_exception(exception);
+    };
+    state.batch.context = &state;
+    state.batch.pending = graph.size();
+
+    for (std::size_t i = 0; i < graph.size(); ++i) state.remaining_predecessors[i] = graph.predecessorCount(i);
+    for (std::size_t i = 0; i < graph.size(); ++i)
+    {
+        if (graph.predecessorCount(i) == 0) push(state.batch, i, 1);
+    }
+    wait(state.batch);
+}
+
+void WorkerPool::parallelFor(std::size_t count, void (*invoke)(const void*, std::size_t), const void* context)
+{
+    if (count == 0) return;
+
+    Batch batch;
+    batch.invoke = invoke;
+    batch.context = context;
+    batch.pending = count;
+    //The calling thread starts with the first job rather than queuing it
+    push(batch, 1, count - 1);
+    execute({ &batch, 0 });
+    wait(batch);
+}
+
+void WorkerPool::push(Batch& batch, std::size_t first, std::size_t count)
+{
+    if (count == 0) return;
+    {
+        Queue& queue = *_queues[queueIndex()];
+        std::scoped_lock lock(queue.mutex);
+        for (std::size_t i = first; i < first + count; ++i) queue.jobs.push_back({ &batch, i });
+    }
+    _queued.fetch_add(count, std::memory_order_release);
+    {
+        //Makes sure that a worker about to sleep sees the jobs before waiting
+        std::scoped_lock lock(_sleep_mutex);
+    }
+    if (count == 1) _sleep_cv.notify_one();
+    else _sleep_cv.notify_all();
+}
+
+//Takes the most recent job of the queue of the calling thread, or else steals the oldest one of another queue
+bool WorkerPool::executeOne()
+{
+    if (_queued.load(std::memory_order_acquire) == 0) return false;
+
+    std::size_t own = queueIndex();
+    for (std::size_t i = 0; i < _queues.size(); ++i)
+    {
+        Queue& queue = *_queues[(own + i) % _queues.size()];
+        std::unique_lock lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+
+        Job job;
+        if (i == 0)
+        {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+        lock.unlock();
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        execute(job);
+        return true;
+    }
+    return false;
+}
+
+void WorkerPool::execute(Job job)
+{
+    Batch& batch = *job.batch;
+    try
+    {
+        batch.invoke(batch.context, job.index);
+    }
+    catch (...)
+    {
+        std::scoped_lock lock(batch.exception_mutex);
+        if (!batch.exception) batch.exception = std::current_exception();
+    }
+    //Last access to the batch, which the waiting thread may destroy right after
+    if (batch.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        //Same as in push, the waiting thread sees the batch done before sleeping or is woken
+        {
+            std::scoped_lock lock(_sleep_mutex);
+        }
+        _sleep_cv.notify_all();
+    }
+}
+
+//Helps with any queued job until the batch is done. When none is queued, the jobs left are running on other threads and
+//the calling thread sleeps until the last of them finishes or another job is queued
+void WorkerPool::wait(Batch& batch)
+{
+    while (batch.pending.load(std::memory_order_acquire) > 0)
+    {
+        if (executeOne()) continue;
+        std::unique_lock lock(_sleep_mutex);
+        _sleep_cv.wait(lock, [this, &batch] {
+            return batch.pending.load(std::memory_order_acquire) == 0 || _queued.load(std::memory_order_acquire) > 0;
+        });
+    }
+    if (batch.exception) std::rethrow_exception(batch.exception);
+}
+
+std::size_t WorkerPool::queueIndex() const
+{
+    return current_pool == this ? current_queue : _queues.size() - 1;
+}
+
+void WorkerPool::workerLoop(std::stop_token stop, std::size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+    while (!stop.stop_requested())
+    {
+        if (executeOne()) continue;
+        std::unique_lock lock(_sleep_mutex);
+        _sleep_cv.wait(lock, stop, [this] { return _queued.load(std::memory_order_acquire) > 0; });
+    }
+}
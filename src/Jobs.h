@@ -0,0 +1,101 @@
+#ifndef CGT_JOBS_H
+#define CGT_JOBS_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <stop_token>
+#include <utility>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <type_traits>
+
+//Dependency graph between tasks identified by their index. Built once and executed any number of times
+class TaskGraph
+{
+public:
+    void clear();
+    std::size_t add(); //Returns the index of the new task
+    void precede(std::size_t before, std::size_t after);
+
+    std::size_t size() const;
+    const std::vector<std::size_t>& successors(std::size_t task) const;
+    std::size_t predecessorCount(std::size_t task) const;
+
+private:
+    std::vector<std::vector<std::size_t>> _successors;
+    std::vector<std::size_t> _predecessor_counts;
+};
+
+//Engine wide work stealing pool of worker threads. Each thread pushes the jobs it spawns to its own queue and takes from
+//its back, idle threads steal from the front of the others. Threads waiting for their jobs execute queued ones meanwhile,
+//so that jobs may themselves run graphs or parallel loops. The calling thread takes part in the execution
+class WorkerPool
+{
+public:
+    static WorkerPool& instance();
+
+    explicit WorkerPool(unsigned worker_count);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool();
+
+    unsigned workerCount() const;
+
+    //Runs func on every task of the graph, each only once all of its predecessors are done. Blocks until the whole graph is done.
+    //Rethrows the first exception thrown by a task, after the remaining tasks are done
+    void run(const TaskGraph& graph, const std::function<void(std::size_t)>& func);
+
+    //Calls func(i) for every i in [0, count), concurrently. Blocks and rethrows like run. Does not allocate
+    template<typename F>
+    void parallelFor(std::size_t count, F&& func)
+    {
+        auto invoke = [](const void* f, std::size_t i) { (*static_cast<std::remove_reference_t<F>*>(const_cast<void*>(f)))(i); };
+        parallelFor(count, invoke, &func);
+    }
+
+private:
+    //Jobs spawned together and waited for as a whole
+    struct Batch
+    {
+        void (*invoke)(const void* context, std::size_t index);
+        const void* context;
+        std::atomic<std::size_t> pending;
+        std::mutex exception_mutex;
+        std::exception_ptr exception;
+    };
+
+    struct Job
+    {
+        Batch* batch;
+        std::size_t index;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void parallelFor(std::size_t count, void (*invoke)(const void*, std::size_t), const void* context);
+    void push(Batch& batch, std::size_t first, std::size_t count);
+    bool executeOne();
+    void execute(Job job);
+    void wait(Batch& batch);
+    std::size_t queueIndex() const; //Of the calling thread
+    void workerLoop(std::stop_token stop, std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> _queues; //One per worker, then one shared by the other threads
+    std::atomic<std::size_t> _queued = 0;
+    std::mutex _sleep_mutex;
+    std::condition_variable_any _sleep_cv;
+
+    std::vector<std::jthread> _workers; //Last so that the workers are stopped before anything else is destroyed
+};
+
+#endif
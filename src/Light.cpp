@@ -1,4 +1,5 @@
 #include "Light.h"
+#include "Profiler.h"
 
 Light::Light(const EntityKey& key)
     :DependentComponent(key)
@@ -22,12 +23,13 @@ Light::Light(const EntityKey& key)
 
 LightData Light::buildData() const
 {
+    CGT_PROFILE_ZONE("Light::buildData");
     LightData data;
-    data.pos = get<Transformation>().matrix() * glm::vec4{0,0,0,1};
+    data.pos = get<Transformation>().renderMatrix() * glm::vec4{0,0,0,1};
     data.color = color;
     data.intensity = intensity;
 
-    glm::mat4 v = get<Transformation>().invMatrix();
+    glm::mat4 v = get<Transformation>().renderInvMatrix();
     glm::mat4 p = glm::perspective(glm::radians(fov / 2), 1.f, 0.1f, range);
     data.vp = p * v;
 
@@ -9,10 +9,15 @@ Model::Model(const EntityKey& key, const Image& img, const MeshData& mesh)
 {
 }
 
+Vector Model::spatialPosition() const
+{
+    return get<Transformation>().worldPosition();
+}
+
 void Model::draw(const glm::mat4& v, const glm::mat4& p) const
 {
-    glm::mat4 m = get<Transformation>().matrix();
-    glm::mat4 inv_mv = get<Transformation>().invMatrix() * inverse(v);
+    glm::mat4 m = get<Transformation>().renderMatrix();
+    glm::mat4 inv_mv = get<Transformation>().renderInvMatrix() * inverse(v);
     float sqr_dist = length2(glm::vec3(v * m * glm::vec4(0, 0, 0, 1)));
 
     glUseProgram(_program);
@@ -48,7 +53,7 @@ void Model::draw(const glm::mat4& v, const glm::mat4& p) const
 
 void Model::drawGeometry(const glm::mat4& v, const glm::mat4& p) const
 {
-    glm::mat4 mv = v * get<Transformation>().matrix();
+    glm::mat4 mv = v * get<Transformation>().renderMatrix();
     float sqr_dist = length2(glm::vec3(mv * glm::vec4(0, 0, 0, 1)));
     glm::mat4 mvp = p * mv;
 
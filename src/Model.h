@@ -11,7 +11,10 @@
 class Model : public DependentComponent<Transformation>
 {
 public:
+    static constexpr ComponentStorage storage = ComponentStorage::Spatial; //Neighbouring models are drawn one after the other
+
     Model(const EntityKey& key, const Image& img, const MeshData& mesh);
+    Vector spatialPosition() const;
     void draw(const glm::mat4& v, const glm::mat4& p) const;
     void drawGeometry(const glm::mat4& v, const glm::mat4& p) const;
     void addLod(const MeshData& data, float after_dist);
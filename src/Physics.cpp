@@ -1,5 +1,6 @@
 #include "Physics.h"
 #include "Collider.h"
+#include "Profiler.h"
 #include <iterator>
 #include <glm/gtx/norm.hpp>
 
@@ -42,19 +43,20 @@ Physics& Physics::instance()
     return p;
 }
 
-std::vector<CollisionVolume*> Physics::overlap(const AnyCol& col) const
+std::pmr::vector<CollisionVolume*> Physics::overlap(const AnyCol& col, std::pmr::memory_resource* resource) const
 {
-    std::vector<CollisionVolume*> result;
+    CGT_PROFILE_ZONE("Physics::overlap");
+    std::pmr::vector<CollisionVolume*> result(resource);
     for (auto& e : _statics)
     {
-        if (auto inter = intersect(e->buildCollisions(), col))
+        if (intersect(e->buildCollisions(), col))
         {
             result.push_back(&getCv(e));
         }
     }
     for (auto& e : _dynamics)
     {
-        if (auto inter = intersect(e.first->buildCollisions(), col))
+        if (intersect(e.first->buildCollisions(), col))
         {
             result.push_back(&getCv(e));
         }
@@ -65,11 +67,13 @@ std::vector<CollisionVolume*> Physics::overlap(const AnyCol& col) const
 
 std::optional<SweepResult> Physics::sweep(const CollisionVolume& col, const glm::vec3& movement) const
 {
-    return sweep(col.buildCollisions(), movement, { &col });
+    const CollisionVolume* self = &col;
+    return sweep(col.buildCollisions(), movement, { &self, 1 });
 }
 
-std::optional<SweepResult> Physics::sweep(const AnyCol& col, const glm::vec3& movement, const std::vector<const CollisionVolume*>& to_ignore) const
+std::optional<SweepResult> Physics::sweep(const AnyCol& col, const glm::vec3& movement, std::span<const CollisionVolume* const> to_ignore) const
 {
+    CGT_PROFILE_ZONE("Physics::sweep");
     std::optional<SweepResult> result;
     float lowest_t = 2;
     for (auto& e : _statics)
@@ -107,11 +111,12 @@ void Physics::add(CollisionVolume& c)
     if (status != Status::Dynamic)
     {
         status = Status::Static;
-        _statics.emplace(getBoundsFor(_statics, eptr).second, c);
+        auto [it, sentinel] = getBoundsFor(_statics, eptr);
+        if (std::find_if(it, sentinel, [&c](const auto& v) { return &getCv(v) == &c; }) == sentinel) _statics.emplace(sentinel, c);
         return;
     }
-    std::vector<DynamicInfo> to_add;
     auto [it, sentinel] = getBoundsFor(_dynamics, eptr);
+    if (std::any_of(it, sentinel, [&c](const auto& v) { return v.first == &c; })) return;
     if (!it->first) //This should only happen at start, if the physicsmovement is started before the collisionvolume
     {
         it->first = c;
@@ -126,6 +131,7 @@ void Physics::remove(CollisionVolume& c)
 {
     Entity* eptr = &c.owner();
     auto status_it = _status.find(eptr);
+    if (status_it == _status.end()) return;
 
     bool all_erased = status_it->second == Status::Static? handleCvRemove(_statics, c) : handleCvRemove(_dynamics, c);
     if (all_erased) _status.erase(status_it);
@@ -135,7 +141,12 @@ void Physics::add(PhysicsMovement& m)
 {
     Entity* eptr = &m.owner();
     Status& status = _status[eptr];
-    std::vector<DynamicInfo> to_add;
+    if (status == Status::Dynamic)
+    {
+        auto [it, sentinel] = getBoundsFor(_dynamics, eptr);
+        if (std::any_of(it, sentinel, [&m](const DynamicInfo& v) { return v.second == &m; })) return;
+    }
+    std::pmr::vector<DynamicInfo> to_add(FrameArena::resource());
     if (status == Status::None)
     {
         to_add.emplace_back(nullptr, m);
@@ -162,7 +173,7 @@ void Physics::remove(PhysicsMovement& m)
     auto [it, sentinel] = getBoundsFor(_dynamics, eptr);
     if (it == sentinel) return;
 
-    std::vector<WeakRef<CollisionVolume>> to_add;
+    std::pmr::vector<WeakRef<CollisionVolume>> to_add(FrameArena::resource());
     to_add.reserve(sentinel - it);
     for (auto i = it; i != sentinel; ++i)
     {
@@ -2,11 +2,14 @@
 #define CGT_PHYSICS_H
 
 #include <vector>
+#include <span>
+#include <memory_resource>
 #include <utility>
 #include <variant>
 #include <unordered_map>
 #include "WeakRef.hpp"
 #include "Geometry.h"
+#include "FrameArena.h"
 
 class Entity;
 class CollisionVolume;
@@ -18,13 +21,15 @@ struct SweepResult : public Intersection
     PhysicsMovement* other_physics;
 };
 
+//Adding and removing are idempotent. The volumes of entities released to an EntityPool are removed until acquired again
 class Physics
 {
 public:
     static Physics& instance();
-    std::vector<CollisionVolume*> overlap(const AnyCol& col) const;
+    //Allocated from the FrameArena by default, so not to be kept beyond the current update or tick
+    std::pmr::vector<CollisionVolume*> overlap(const AnyCol& col, std::pmr::memory_resource* resource = FrameArena::resource()) const;
     std::optional<SweepResult> sweep(const CollisionVolume& col, const glm::vec3& movement) const;
-    std::optional<SweepResult> sweep(const AnyCol& col, const glm::vec3& movement, const std::vector<const CollisionVolume*>& to_ignore = {}) const;
+    std::optional<SweepResult> sweep(const AnyCol& col, const glm::vec3& movement, std::span<const CollisionVolume* const> to_ignore = {}) const;
 
     void add(CollisionVolume&);
     void remove(CollisionVolume&);
@@ -0,0 +1,88 @@
+#ifndef CGT_PREFAB_HPP
+#define CGT_PREFAB_HPP
+
+#include "World.h"
+#include "Entity.h"
+#include "Component.h"
+#include <vector>
+#include <span>
+#include <functional>
+#include <utility>
+#include <concepts>
+#include <cstddef>
+#include <algorithm>
+
+//Description of an entity as its components and their constructor arguments, built many times by World::instantiate.
+//The arguments are copied into the prefab and given to the constructor of every instance as const lvalues.
+//Dependencies must be added before their dependents, otherwise they are built with default values as usual.
+class Prefab
+{
+    friend class World;
+public:
+    template<std::derived_from<Component> C, typename... Args>
+    Prefab& add(Args&&... args)
+    {
+        _parts.push_back({
+            [](World& world, std::size_t count) { world.reserveNewComponents<C>(count); },
+            [... args = std::forward<Args>(args)](std::span<Entity* const> entities) {
+                for (Entity* e : entities) e->buildComponent<C>(args...);
+            } });
+        return *this;
+    }
+
+    std::size_t size() const
+    {
+        return _parts.size();
+    }
+
+private:
+    struct Part
+    {
+        void (*reserve)(World&, std::size_t);
+        std::function<void(std::span<Entity* const>)> build; //One component for each of the entities
+    };
+
+    //Entities are built in batches of this many, one part at a time, small enough to stay in cache between the parts
+    static constexpr std::size_t BatchSize = 256;
+
+    std::vector<Part> _parts;
+};
+
+template<std::invocable<Entity&, std::size_t> F>
+std::vector<Entity*> World::instantiate(const Prefab& prefab, std::size_t count, F&& initializer)
+{
+    CGT_PROFILE_ZONE("instantiate");
+    std::vector<Entity*> entities;
+    entities.reserve(count);
+    _entities.reserve(count);
+    for (const auto& part : prefab._parts) part.reserve(*this, count);
+    for (std::size_t first = 0; first < count; first += Prefab::BatchSize)
+    {
+        std::size_t last = std::min(count, first + Prefab::BatchSize);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            Entity& e = createEntity();
+            e._components.reserve(prefab._parts.size());
+            entities.push_back(&e);
+        }
+        std::span<Entity* const> batch(entities.data() + first, last - first);
+        for (const auto& part : prefab._parts) part.build(batch);
+        for (std::size_t i = first; i < last; ++i) initializer(*entities[i], i);
+    }
+    return entities;
+}
+
+inline std::vector<Entity*> World::instantiate(const Prefab& prefab, std::size_t count)
+{
+    return instantiate(prefab, count, [](Entity&, std::size_t) {});
+}
+
+inline Entity& World::instantiate(const Prefab& prefab)
+{
+    Entity* e = &createEntity();
+    e->_components.reserve(prefab._parts.size());
+    for (const auto& part : prefab._parts) part.build(std::span(&e, 1));
+    return *e;
+}
+
+#endif
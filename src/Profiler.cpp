@@ -0,0 +1,120 @@
+#include "Profiler.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <algorithm>
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        std::string_view detail;
+        Profiler::Clock::time_point begin;
+        Profiler::Clock::time_point end;
+    };
+
+    struct ThreadBuffer
+    {
+        explicit ThreadBuffer(unsigned id) : thread_id(id), events(Profiler::RingCapacity) {}
+
+        std::mutex mutex; //Only contended while writing the trace
+        unsigned thread_id;
+        std::vector<Event> events;
+        std::size_t count = 0; //Total recorded, the next event goes to count % RingCapacity
+    };
+
+    //Buffers are shared with the registry so that the events of exited threads can still be written
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        const Profiler::Clock::time_point origin = Profiler::Clock::now();
+    };
+
+    Registry& registry()
+    {
+        static Registry r;
+        return r;
+    }
+
+    ThreadBuffer& threadBuffer()
+    {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+            Registry& r = registry();
+            std::scoped_lock lock(r.mutex);
+            return r.buffers.emplace_back(std::make_shared<ThreadBuffer>(static_cast<unsigned>(r.buffers.size())));
+        }();
+        return *buffer;
+    }
+
+    void writeEscaped(std::ostream& out, std::string_view s)
+    {
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+    }
+}
+
+namespace Profiler
+{
+    void record(const char* name, std::string_view detail, Clock::time_point begin, Clock::time_point end)
+    {
+        ThreadBuffer& b = threadBuffer();
+        std::scoped_lock lock(b.mutex);
+        b.events[b.count++ % RingCapacity] = { name, detail, begin, end };
+    }
+
+    void writeChromeTrace(std::ostream& out)
+    {
+        Registry& r = registry();
+        std::scoped_lock lock(r.mutex);
+
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (auto& b : r.buffers)
+        {
+            std::scoped_lock buffer_lock(b->mutex);
+            std::size_t kept = std::min(b->count, RingCapacity);
+            for (std::size_t i = b->count - kept; i < b->count; ++i)
+            {
+                const Event& e = b->events[i % RingCapacity];
+                out << (first ? "\n" : ",\n");
+                first = false;
+
+                out << "{\"name\":\"";
+                writeEscaped(out, e.name);
+                if (!e.detail.empty())
+                {
+                    out << ' ';
+                    writeEscaped(out, e.detail);
+                }
+                out << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << b->thread_id
+                    << ",\"ts\":" << std::chrono::duration<double, std::micro>(e.begin - r.origin).count()
+                    << ",\"dur\":" << std::chrono::duration<double, std::micro>(e.end - e.begin).count() << '}';
+            }
+            b->count = 0;
+        }
+        out << "\n]}\n";
+    }
+
+    void writeChromeTrace(const std::filesystem::path& file)
+    {
+        std::ofstream out(file);
+        writeChromeTrace(out);
+    }
+
+    void clear()
+    {
+        Registry& r = registry();
+        std::scoped_lock lock(r.mutex);
+        for (auto& b : r.buffers)
+        {
+            std::scoped_lock buffer_lock(b->mutex);
+            b->count = 0;
+        }
+    }
+}
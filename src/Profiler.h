@@ -0,0 +1,85 @@
+#ifndef CGT_PROFILER_H
+#define CGT_PROFILER_H
+
+#include <chrono>
+#include <string_view>
+#include <source_location>
+#include <filesystem>
+#include <ostream>
+
+//Scoped timing zones, recorded into a ring buffer per thread and exported as Chrome trace JSON (chrome://tracing, Perfetto).
+//CGT_PROFILE_ZONE compiles to nothing unless CGT_PROFILE is defined. Names and details must outlive the profiler, string literals
+//or profilerTypeName
+namespace Profiler
+{
+    using Clock = std::chrono::steady_clock;
+
+    //Events kept per thread, the oldest ones are overwritten
+    inline constexpr std::size_t RingCapacity = 1 << 16;
+
+    void record(const char* name, std::string_view detail, Clock::time_point begin, Clock::time_point end);
+
+    //Writes the events of every thread and clears them. Zones still open or recorded concurrently may be missed
+    void writeChromeTrace(std::ostream& out);
+    void writeChromeTrace(const std::filesystem::path& file);
+    void clear();
+}
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name, std::string_view detail = {})
+        : _name(name), _detail(detail), _begin(Profiler::Clock::now())
+    {
+    }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+    ~ProfileZone()
+    {
+        Profiler::record(_name, _detail, _begin, Profiler::Clock::now());
+    }
+
+private:
+    const char* _name;
+    std::string_view _detail;
+    Profiler::Clock::time_point _begin;
+};
+
+namespace impl
+{
+    template<typename T>
+    std::string_view parseProfilerTypeName()
+    {
+        std::string_view f = std::source_location::current().function_name();
+        if (auto p = f.find("T = "); p != std::string_view::npos) //GCC and Clang: "... [with T = Name; ...]" or "... [T = Name]"
+        {
+            f.remove_prefix(p + 4);
+            return f.substr(0, f.find_first_of(";]"));
+        }
+        if (auto p = f.find("parseProfilerTypeName<"); p != std::string_view::npos) //MSVC: "... parseProfilerTypeName<class Name>(void)"
+        {
+            f.remove_prefix(p + 22);
+            f = f.substr(0, f.rfind(">("));
+            for (std::string_view prefix : { "class ", "struct " }) if (f.starts_with(prefix)) f.remove_prefix(prefix.size());
+        }
+        return f;
+    }
+}
+
+//Readable name of T, with static storage duration
+template<typename T>
+std::string_view profilerTypeName()
+{
+    static const std::string_view name = impl::parseProfilerTypeName<T>();
+    return name;
+}
+
+#define CGT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CGT_PROFILE_CONCAT(a, b) CGT_PROFILE_CONCAT_IMPL(a, b)
+#ifdef CGT_PROFILE
+#define CGT_PROFILE_ZONE(...) ProfileZone CGT_PROFILE_CONCAT(cgt_profile_zone_, __LINE__){ __VA_ARGS__ }
+#else
+#define CGT_PROFILE_ZONE(...) ((void)0)
+#endif
+
+#endif
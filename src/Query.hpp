@@ -0,0 +1,121 @@
+#ifndef CGT_QUERY_HPP
+#define CGT_QUERY_HPP
+
+#include <span>
+#include <tuple>
+#include <iterator>
+#include <utility>
+#include <functional>
+#include <cstddef>
+
+class Entity;
+
+//Entities owning a component of each of the types, found by a merge join over the components of each manager, sorted by owner.
+//Yields a std::tuple<Cs&...> per entity, with the first component of each type when an entity owns several. Does not allocate.
+//Invalidated like the component references by the next cleanup of any of the managers
+template<typename... Cs>
+class Query
+{
+    static_assert(sizeof...(Cs) > 0);
+public:
+    class Iterator
+    {
+    public:
+        using value_type = std::tuple<Cs&...>;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator(std::tuple<Cs*...> current, std::tuple<Cs*...> end)
+            : _current(current), _end(end)
+        {
+            align();
+        }
+
+        value_type operator*() const
+        {
+            return std::apply([](Cs*... c) { return value_type(*c...); }, _current);
+        }
+
+        Iterator& operator++()
+        {
+            //Past the other components of the first type of the same owner, so that each entity is yielded once
+            auto& it = std::get<0>(_current);
+            const Entity* owner = &it->owner();
+            do ++it; while (it != std::get<0>(_end) && &it->owner() == owner);
+            align();
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            ++*this;
+        }
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t)
+        {
+            return std::get<0>(it._current) == std::get<0>(it._end);
+        }
+
+    private:
+        //Advances every range to the first owner they all share, or ends the iteration
+        void align()
+        {
+            if (std::get<0>(_current) == std::get<0>(_end)) return;
+
+            const Entity* target = &std::get<0>(_current)->owner();
+            bool aligned = false;
+            while (!aligned)
+            {
+                aligned = true;
+                bool found = [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    return (seek<I>(target, aligned) && ...);
+                }(std::index_sequence_for<Cs...>{});
+
+                if (!found)
+                {
+                    std::get<0>(_current) = std::get<0>(_end);
+                    return;
+                }
+            }
+        }
+
+        template<std::size_t I>
+        bool seek(const Entity*& target, bool& aligned)
+        {
+            auto& it = std::get<I>(_current);
+            auto end = std::get<I>(_end);
+            while (it != end && std::less<const Entity*>{}(&it->owner(), target)) ++it;
+            if (it == end) return false;
+
+            if (&it->owner() != target)
+            {
+                target = &it->owner();
+                aligned = false;
+            }
+            return true;
+        }
+
+        std::tuple<Cs*...> _current;
+        std::tuple<Cs*...> _end;
+    };
+
+    explicit Query(std::span<Cs>... components)
+        : _begin(components.data()...), _end((components.data() + components.size())...)
+    {
+    }
+
+    Iterator begin() const
+    {
+        return Iterator(_begin, _end);
+    }
+
+    std::default_sentinel_t end() const
+    {
+        return {};
+    }
+
+private:
+    std::tuple<Cs*...> _begin;
+    std::tuple<Cs*...> _end;
+};
+
+#endif
@@ -3,12 +3,24 @@
 #include <numbers>
 
 Rotator::Rotator(const EntityKey& key, float rotation_rate)
-    : DependentComponent(key), _rotation_rate(rotation_rate)
+    : DependentComponent(key), HotFields(rotation_rate, 0)
 {
 }
 
+Rotator::Rotator(const EntityKey& key, const Snapshot& s)
+    : DependentComponent(key), HotFields(s.rotation_rate, s.current_rotation)
+{
+}
+
+Rotator::Snapshot Rotator::snapshot(const SnapshotWriter&) const
+{
+    return { hot<RotationRate>(), hot<CurrentRotation>() };
+}
+
 void Rotator::update(Seconds delta)
 {
-    _current_rotation = std::fmod(_current_rotation + _rotation_rate * delta.count(), std::numbers::pi_v<float> * 2);
-    get<Transformation>().rotation(glm::vec3{ 0, _current_rotation, 0 });
+    //delta covers all the updates skipped since the last one it was due at
+    float& rotation = hot<CurrentRotation>();
+    rotation = std::fmod(rotation + hot<RotationRate>() * delta.count(), std::numbers::pi_v<float> * 2);
+    get<Transformation>().rotation(glm::vec3{ 0, rotation, 0 });
 }
@@ -3,17 +3,27 @@
 
 #include "Component.h"
 #include "Transformation.h"
+#include "HotFields.hpp"
 #include <chrono>
 
 
-class Rotator : public DependentComponent<Transformation>
+//Only advances and applies its rotation at the updates it is due, by the time elapsed since the last one, see Throttled.
+//Not parallel: setting the rotation invalidates the Transformations of the children, which belong to other entities
+class Rotator : public DependentComponent<Transformation>, public HotFields<float, float>, public Throttled
 {
 public:
+    struct Snapshot
+    {
+        float rotation_rate;
+        float current_rotation;
+    };
+
     Rotator(const EntityKey& key, float rotation_rate);
+    Rotator(const EntityKey& key, const Snapshot& s);
+    Snapshot snapshot(const SnapshotWriter& writer) const;
     void update(Seconds delta);
 private:
-    float _rotation_rate;
-    float _current_rotation = 0;
+    enum Hot { RotationRate, CurrentRotation };
 };
 
 #endif
@@ -0,0 +1,39 @@
+#include "Significance.h"
+#include <algorithm>
+#include <cmath>
+
+Significance::Significance(const EntityKey& key, float near_distance, float radius)
+    : DependentComponent(key), _near_distance(near_distance), _radius(radius)
+{
+}
+
+void Significance::update(Seconds)
+{
+    Camera* camera = Camera::main();
+    if (!camera)
+    {
+        _visible = true;
+        owner().updateBucket(0);
+        return;
+    }
+
+    const Transformation& view = camera->get<Transformation>();
+    glm::vec3 position = get<Transformation>().worldPosition();
+    float distance = glm::length(position - view.worldPosition());
+    int bucket = distance > _near_distance ? static_cast<int>(std::ceil(std::log2(distance / _near_distance))) : 0;
+
+    //Bounding sphere against the side planes of the frustum in clip space, the near and far planes are left out
+    glm::mat4 projection = camera->projectionMatrix();
+    glm::vec4 clip = projection * view.invMatrix() * glm::vec4(position, 1);
+    _visible = clip.w >= -_radius
+        && std::abs(clip.x) <= clip.w + projection[0][0] * _radius
+        && std::abs(clip.y) <= clip.w + projection[1][1] * _radius;
+    if (!_visible) bucket += HiddenBuckets;
+
+    owner().updateBucket(static_cast<std::uint8_t>(std::min<int>(bucket, MaxBucket)));
+}
+
+bool Significance::visible() const
+{
+    return _visible;
+}
@@ -0,0 +1,34 @@
+#ifndef CGT_SIGNIFICANCE_H
+#define CGT_SIGNIFICANCE_H
+
+#include "Component.h"
+#include "Transformation.h"
+#include "Camera.h"
+#include <cstdint>
+
+
+//Sets the update bucket of its entity from its distance to the main camera and whether it was in view at the last update,
+//so that the Throttled components of far or hidden entities update less often. Within near_distance the bucket is 0,
+//updating every time, then it grows by one each time the distance doubles. Hidden entities go HiddenBuckets further.
+//Without a main camera the bucket is 0
+class Significance : public DependentComponent<Transformation>
+{
+public:
+    using Accesses = std::tuple<Camera>;
+
+    static constexpr std::uint8_t MaxBucket = 3; //Every 8th update
+    static constexpr std::uint8_t HiddenBuckets = 2;
+
+    //radius is that of a sphere around the entity, tested against the view frustum
+    explicit Significance(const EntityKey& key, float near_distance = 10, float radius = 1);
+
+    void update(Seconds delta);
+
+    bool visible() const; //At the last update
+private:
+    float _near_distance;
+    float _radius;
+    bool _visible = true;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef CGT_SLABPOOL_HPP
+#define CGT_SLABPOOL_HPP
+
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <cstddef>
+
+//Stores objects in fixed size slabs, giving them stable addresses. Freed slots are recycled first, most recent first.
+//T only needs to be complete where the member functions are used. The slabs are allocated from the given memory resource.
+template<typename T, std::size_t SlabSize = 256>
+class SlabPool
+{
+public:
+    explicit SlabPool(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : _slabs(resource) {}
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+    ~SlabPool()
+    {
+        forEach([](T& t) { t.~T(); });
+        std::pmr::polymorphic_allocator<Slot> allocator = _slabs.get_allocator();
+        for (Slot* slab : _slabs) allocator.deallocate(slab, SlabSize);
+    }
+
+    //construct placement news the object in the storage it is given and returns it. Lets T keep a private constructor
+    template<typename F>
+    T& create(F&& construct)
+    {
+        if (!_free) grow();
+
+        Slot* slot = _free;
+        T* t = construct(static_cast<void*>(slot->storage));
+        _free = slot->next_free;
+        slot->live = true;
+        ++_size;
+        return *t;
+    }
+
+    //Makes room for count more objects, so that creating them does not allocate
+    void reserve(std::size_t count)
+    {
+        std::size_t capacity = _slabs.size() * SlabSize;
+        if (capacity >= _size + count) return;
+        _slabs.reserve(_slabs.size() + (_size + count - capacity + SlabSize - 1) / SlabSize);
+        for (; capacity < _size + count; capacity += SlabSize) grow();
+    }
+
+    //O(1), t must come from this pool
+    void destroy(T& t)
+    {
+        Slot* slot = reinterpret_cast<Slot*>(&t); //storage is the first member of Slot
+        t.~T();
+        slot->live = false;
+        slot->next_free = _free;
+        _free = slot;
+        --_size;
+    }
+
+    //In address order within each slab
+    template<typename F>
+    void forEach(F&& func)
+    {
+        for (auto& slab : _slabs)
+        {
+            for (std::size_t i = 0; i < SlabSize; ++i)
+            {
+                if (slab[i].live) func(*std::launder(reinterpret_cast<T*>(slab[i].storage)));
+            }
+        }
+    }
+
+    template<typename F>
+    void forEach(F&& func) const
+    {
+        for (auto& slab : _slabs)
+        {
+            for (std::size_t i = 0; i < SlabSize; ++i)
+            {
+                if (slab[i].live) func(*std::launder(reinterpret_cast<const T*>(slab[i].storage)));
+            }
+        }
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    struct Slot
+    {
+        alignas(T) std::byte storage[sizeof(T)];
+        Slot* next_free;
+        bool live;
+    };
+
+    void grow()
+    {
+        std::pmr::polymorphic_allocator<Slot> allocator = _slabs.get_allocator();
+        Slot* slab = _slabs.emplace_back(allocator.allocate(SlabSize));
+        for (std::size_t i = SlabSize; i-- > 0;)
+        {
+            slab[i].live = false;
+            slab[i].next_free = _free;
+            _free = &slab[i];
+        }
+    }
+
+    std::pmr::vector<Slot*> _slabs; //Of SlabSize slots each
+    Slot* _free = nullptr;
+    std::size_t _size = 0;
+};
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef CGT_SNAPSHOT_HPP
+#define CGT_SNAPSHOT_HPP
+
+#include "World.h"
+#include "Entity.h"
+#include "Component.h"
+#include <vector>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <concepts>
+#include <type_traits>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <ostream>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <cassert>
+
+//Binary snapshot of a World. The file is a header followed by one block per component type of the ComponentList given to
+//World::saveSnapshot, in its order. A block is a header followed by a contiguous array of SnapshotRecord<C>, padded to 16 bytes,
+//so that a loaded or memory mapped file is read without any per field parsing. Entities are referred to by their index
+//in the snapshot. The format depends on the layout of the records, snapshots are meant to be read by the same build.
+//
+//A component type C takes part by providing:
+// - a trivially copyable "struct Snapshot" holding its state,
+// - "Snapshot snapshot(const SnapshotWriter&) const",
+// - a "C(const EntityKey&, const Snapshot&)" constructor,
+// - optionally "void restoreLinks(const Snapshot&, const SnapshotReader&)", called once every component of its block is built,
+//   to point to components of other entities.
+//Dependencies must come before their dependents in the ComponentList, as they are found rather than built with default values.
+//State rebuilt when components start, like the Physics registry, is not stored.
+
+inline constexpr std::uint32_t NoSnapshotEntity = ~std::uint32_t{};
+
+class SnapshotWriter
+{
+    friend class World;
+public:
+    //NoSnapshotEntity for nullptr and entities not in the snapshot
+    std::uint32_t indexOf(const Entity* e) const
+    {
+        auto it = std::lower_bound(_entities.begin(), _entities.end(), e, std::less<const Entity*>{});
+        return it != _entities.end() && *it == e ? static_cast<std::uint32_t>(it - _entities.begin()) : NoSnapshotEntity;
+    }
+
+private:
+    std::vector<const Entity*> _entities; //Sorted
+};
+
+class SnapshotReader
+{
+    friend class World;
+public:
+    //nullptr for NoSnapshotEntity
+    Entity* entity(std::uint32_t index) const
+    {
+        return index < _entities.size() ? _entities[index] : nullptr;
+    }
+
+private:
+    std::vector<Entity*> _entities;
+};
+
+template<typename C>
+concept Snapshottable = std::is_trivially_copyable_v<typename C::Snapshot>
+    && requires (const C& c, const SnapshotWriter& w) { { c.snapshot(w) } -> std::same_as<typename C::Snapshot>; }
+    && std::constructible_from<C, const EntityKey&, const typename C::Snapshot&>;
+
+template<typename C>
+struct SnapshotRecord
+{
+    std::uint32_t entity;
+    typename C::Snapshot data;
+};
+
+namespace impl
+{
+    inline constexpr char SnapshotMagic[4] = { 'C', 'G', 'T', 'S' };
+    inline constexpr std::uint32_t SnapshotVersion = 1;
+    inline constexpr std::size_t SnapshotAlignment = 16;
+
+    struct SnapshotHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t entity_count;
+        std::uint32_t block_count;
+    };
+
+    struct SnapshotBlockHeader
+    {
+        std::uint32_t type_index; //In the ComponentList
+        std::uint32_t record_size;
+        std::uint64_t count;
+    };
+
+    inline std::size_t snapshotPadding(std::size_t size)
+    {
+        return (SnapshotAlignment - size % SnapshotAlignment) % SnapshotAlignment;
+    }
+
+    inline void checkSnapshotSize(std::span<const std::byte> data, std::size_t offset, std::size_t size, std::size_t count = 1)
+    {
+        if (data.size() < offset || (data.size() - offset) / size < count) throw std::runtime_error("Truncated snapshot");
+    }
+
+    template<typename T>
+    T readSnapshot(std::span<const std::byte> data, std::size_t& offset)
+    {
+        checkSnapshotSize(data, offset, sizeof(T));
+        T t;
+        std::memcpy(&t, data.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return t;
+    }
+
+    //Throws if the block of C at offset does not match the ComponentList, does not fit in data or refers to an entity
+    //out of the snapshot. Moves offset past the block
+    template<typename C>
+    void checkSnapshotBlock(std::uint32_t type_index, std::span<const std::byte> data, std::size_t& offset, std::uint32_t entity_count)
+    {
+        auto header = readSnapshot<SnapshotBlockHeader>(data, offset);
+        if (header.type_index != type_index || header.record_size != sizeof(SnapshotRecord<C>))
+        {
+            throw std::runtime_error("Snapshot does not match the component list");
+        }
+        checkSnapshotSize(data, offset, sizeof(SnapshotRecord<C>), header.count);
+
+        static_assert(offsetof(SnapshotRecord<C>, entity) == 0);
+        std::size_t first = offset;
+        for (std::size_t i = 0; i < header.count; ++i, offset += sizeof(SnapshotRecord<C>))
+        {
+            std::size_t record = offset;
+            if (readSnapshot<std::uint32_t>(data, record) >= entity_count) throw std::runtime_error("Invalid entity in snapshot");
+        }
+        offset += snapshotPadding(offset - first);
+    }
+}
+
+template<typename... Cs>
+void World::saveSnapshot(ComponentList<Cs...>, std::ostream& out) const
+{
+    static_assert((Snapshottable<Cs> && ...), "Every type of a snapshot must be Snapshottable");
+
+    SnapshotWriter writer;
+    writer._entities.reserve(_entities.size());
+    //Entities released to an EntityPool are left out like the destroyed ones, their pool would not be restored
+    _entities.forEach([&writer](const Entity& e) { if (!e._marked_for_destroy && e._active) writer._entities.push_back(&e); });
+    std::sort(writer._entities.begin(), writer._entities.end(), std::less<const Entity*>{});
+
+    impl::SnapshotHeader header{ {}, impl::SnapshotVersion, static_cast<std::uint32_t>(writer._entities.size()), sizeof...(Cs) };
+    std::memcpy(header.magic, impl::SnapshotMagic, sizeof(header.magic));
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::uint32_t type_index = 0;
+    (saveSnapshotBlock<Cs>(type_index++, writer, out), ...);
+    if (!out) throw std::runtime_error("Unable to write snapshot");
+}
+
+template<typename... Cs>
+void World::saveSnapshot(ComponentList<Cs...> list, const std::filesystem::path& file) const
+{
+    std::ofstream out(file, std::ios::binary);
+    saveSnapshot(list, out);
+}
+
+template<typename... Cs>
+void World::loadSnapshot(ComponentList<Cs...>, std::span<const std::byte> data)
+{
+    static_assert((Snapshottable<Cs> && ...), "Every type of a snapshot must be Snapshottable");
+
+    std::size_t offset = 0;
+    auto header = impl::readSnapshot<impl::SnapshotHeader>(data, offset);
+    if (std::memcmp(header.magic, impl::SnapshotMagic, sizeof(header.magic)) != 0 || header.version != impl::SnapshotVersion)
+    {
+        throw std::runtime_error("Not a snapshot or unsupported version");
+    }
+    if (header.block_count != sizeof...(Cs)) throw std::runtime_error("Snapshot does not match the component list");
+
+    //Every block is checked before anything is built, so that a corrupt or truncated snapshot leaves the world unchanged
+    std::size_t blocks = offset;
+    std::uint32_t type_index = 0;
+    (impl::checkSnapshotBlock<Cs>(type_index++, data, offset, header.entity_count), ...);
+
+    SnapshotReader reader;
+    reader._entities.reserve(header.entity_count);
+    for (std::uint32_t i = 0; i < header.entity_count; ++i) reader._entities.push_back(&createEntity());
+
+    offset = blocks;
+    type_index = 0;
+    (loadSnapshotBlock<Cs>(type_index++, data, offset, reader), ...);
+}
+
+template<typename... Cs>
+void World::loadSnapshot(ComponentList<Cs...> list, const std::filesystem::path& file)
+{
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("Unable to open snapshot");
+    std::vector<std::byte> data(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(data.data()), data.size());
+    loadSnapshot(list, std::span<const std::byte>(data));
+}
+
+template<typename C>
+void World::saveSnapshotBlock(std::uint32_t type_index, const SnapshotWriter& writer, std::ostream& out) const
+{
+    //Value initialized so that the padding between the fields of the records is zero
+    std::vector<SnapshotRecord<C>> records;
+    if (ComponentManager<C>* manager = findManager<C>())
+    {
+        records.resize(manager->components().size());
+        std::size_t count = 0;
+        for (const C& c : manager->components())
+        {
+            if (c.shouldSkip()) continue; //Destroyed or owned by a released entity
+            records[count].entity = writer.indexOf(&c.owner());
+            records[count].data = c.snapshot(writer);
+            ++count;
+        }
+        records.resize(count);
+    }
+
+    impl::SnapshotBlockHeader header{ type_index, sizeof(SnapshotRecord<C>), records.size() };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::size_t size = records.size() * sizeof(SnapshotRecord<C>);
+    out.write(reinterpret_cast<const char*>(records.data()), size);
+    static constexpr char padding[impl::SnapshotAlignment] = {};
+    out.write(padding, impl::snapshotPadding(size));
+}
+
+template<typename C>
+void World::loadSnapshotBlock([[maybe_unused]] std::uint32_t type_index, std::span<const std::byte> data, std::size_t& offset, const SnapshotReader& reader)
+{
+    //Already checked by impl::checkSnapshotBlock
+    auto header = impl::readSnapshot<impl::SnapshotBlockHeader>(data, offset);
+    assert(header.type_index == type_index);
+
+    std::size_t first = offset;
+    std::vector<C*> built(header.count);
+    for (std::size_t i = 0; i < header.count; ++i)
+    {
+        auto record = impl::readSnapshot<SnapshotRecord<C>>(data, offset);
+        Entity* e = reader.entity(record.entity);
+        built[i] = &e->buildComponent<C>(record.data);
+    }
+
+    if constexpr (requires (C& c, const typename C::Snapshot& s) { c.restoreLinks(s, reader); })
+    {
+        offset = first;
+        for (C* c : built) c->restoreLinks(impl::readSnapshot<SnapshotRecord<C>>(data, offset).data, reader);
+    }
+    offset = first + header.count * sizeof(SnapshotRecord<C>);
+    offset += impl::snapshotPadding(offset - first);
+}
+
+#endif
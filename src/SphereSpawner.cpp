@@ -4,38 +4,63 @@
 #include "Collider.h"
 #include "Utility.h"
 #include "TimedDestroy.h"
+#include "Prefab.hpp"
 
 using namespace std::chrono_literals;
 
 namespace
 {
-    MeshData simpleSphere()
+    const Prefab& spherePrefab()
     {
-        MeshData data;
-        setUnitSphere(data);
-        return data;
+        static const Prefab prefab = [] {
+            MeshData data;
+            setUnitSphere(data);
+            Prefab p;
+            p.add<Transformation>(glm::vec3{ 0,0,0 }, Quaternion{ 1,0,0,0 }, glm::vec3{ 0.1,0.1,0.1 });
+            p.add<Model>(Utility::loadImage("res/earth.jpg"), std::move(data));
+            p.add<CollisionVolume>();
+            p.add<PhysicsMovement>();
+            p.add<TimedDestroy>();
+            return p;
+        }();
+        return prefab;
     }
 }
 
+SphereSpawner::SphereSpawner(const EntityKey& key)
+    : DependentComponent(key), _spheres(world(), spherePrefab())
+{
+}
+
 void SphereSpawner::start()
 {
-    Inputs::instance().attack.valueChanged.add(*this, &SphereSpawner::spawnInput);
+    _behaviour = spawnOnAttack(*this);
 }
 
-void SphereSpawner::spawnInput(bool val)
+void SphereSpawner::stop()
 {
-    static MeshData sphere_data = simpleSphere();
+    _spheres.clear();
+}
 
-    if (!val) return;
+Behaviour SphereSpawner::spawnOnAttack(WeakRef<SphereSpawner> self)
+{
+    while (true)
+    {
+        if (co_await fired(Inputs::instance().attack.valueChanged)) self->spawn();
+    }
+}
 
+void SphereSpawner::spawn()
+{
     glm::vec3 dir = get<Transformation>().rotation() * glm::vec3{ 0,0,-1 };
-    Entity& sphere = world().createEntity();
-    sphere.buildComponent<Model>(Utility::loadImage("res/earth.jpg"), sphere_data);
-    sphere.getOrBuildComponent<CollisionVolume>().volume = CollisionSphere{ 0.1 };
-    sphere.getOrBuildComponent<PhysicsMovement>().velocity(dir * 2.f);
-    sphere.getOrBuildComponent<PhysicsMovement>().mass = 1000;
-    Transformation& sphere_t = sphere.getOrBuildComponent<Transformation>();
-    sphere_t.translation(get<Transformation>().translation());
-    sphere_t.scale({ 0.1,0.1,0.1 });
-    sphere.buildComponent<TimedDestroy>().timer(2500ms);
+    glm::vec3 position = get<Transformation>().translation();
+    _spheres.acquire([&](Entity& sphere) {
+        sphere.findComponent<CollisionVolume>()->volume = CollisionSphere{ 0.1 };
+        PhysicsMovement& movement = *sphere.findComponent<PhysicsMovement>();
+        movement.velocity(dir * 2.f);
+        movement.mass(1000);
+        sphere.findComponent<Transformation>()->translation(position);
+        sphere.findComponent<Transformation>()->rotation(Quaternion{ 1,0,0,0 });
+        sphere.findComponent<TimedDestroy>()->timer(2500ms);
+    });
 }
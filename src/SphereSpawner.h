@@ -3,15 +3,24 @@
 
 #include "Component.h"
 #include "Transformation.h"
+#include "Behaviour.hpp"
+#include "EntityPool.h"
 
 
 class SphereSpawner : public DependentComponent<Transformation>
 {
 public:
-    using DependentComponent::DependentComponent;
+    SphereSpawner(const EntityKey& key);
 
     void start();
-    void spawnInput(bool val);
+    void stop(); //Destroys the released spheres, those in flight are destroyed rather than released once the pool is gone
+    void spawn();
+
+private:
+    static Behaviour spawnOnAttack(WeakRef<SphereSpawner> self);
+
+    Behaviour _behaviour;
+    EntityPool _spheres; //Released by their TimedDestroy
 };
 
 #endif
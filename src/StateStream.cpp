@@ -0,0 +1,477 @@
+#include "StateStream.h"
+#include "Collider.h"
+#include "Entity.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+namespace
+{
+    constexpr char Magic[4] = { 'C', 'G', 'T', 'D' };
+    constexpr std::uint32_t Version = 1;
+
+    //Change mask of an entity
+    enum Field : std::uint8_t
+    {
+        Position = 1,
+        Rotation = 2,
+        Scale = 4,
+        Velocity = 8
+    };
+
+    struct StreamHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        float position_step;
+        float scale_step;
+        float velocity_step;
+        std::uint32_t keyframe_interval;
+    };
+
+    struct FrameHeader
+    {
+        std::uint32_t key;
+        std::uint32_t size; //Of the payload following
+        float time;
+    };
+
+    //Components other than the largest of a unit quaternion are within +-1/sqrt(2)
+    constexpr float RotationRange = 0.70710678f;
+    constexpr std::uint64_t RotationMax = (1 << 15) - 1;
+    constexpr std::size_t RotationBytes = 6; //2 bits for the index of the largest component, 15 bits for each of the others
+
+    std::uint64_t zigzag(std::int64_t v)
+    {
+        return static_cast<std::uint64_t>(v) << 1 ^ static_cast<std::uint64_t>(v >> 63);
+    }
+
+    std::int64_t unzigzag(std::uint64_t v)
+    {
+        return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+    }
+
+    std::array<std::int64_t, 3> quantize(glm::vec3 v, float step)
+    {
+        return { std::llround(v.x / step), std::llround(v.y / step), std::llround(v.z / step) };
+    }
+
+    glm::vec3 dequantize(const std::array<std::int64_t, 3>& q, float step)
+    {
+        return { static_cast<float>(q[0]) * step, static_cast<float>(q[1]) * step, static_cast<float>(q[2]) * step };
+    }
+
+    //Smallest three, the largest component is made positive and found back from the norm
+    std::uint64_t packRotation(Quaternion q)
+    {
+        q = glm::normalize(q);
+        float c[4] = { q.x, q.y, q.z, q.w };
+        int largest = 0;
+        for (int i = 1; i < 4; ++i) if (std::abs(c[i]) > std::abs(c[largest])) largest = i;
+        float sign = c[largest] < 0 ? -1.f : 1.f;
+
+        std::uint64_t packed = static_cast<std::uint64_t>(largest);
+        int shift = 2;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i == largest) continue;
+            float n = std::clamp(c[i] * sign / RotationRange * 0.5f + 0.5f, 0.f, 1.f);
+            packed |= static_cast<std::uint64_t>(std::lround(n * RotationMax)) << shift;
+            shift += 15;
+        }
+        return packed;
+    }
+
+    Quaternion unpackRotation(std::uint64_t packed)
+    {
+        int largest = static_cast<int>(packed & 3);
+        float c[4];
+        float sum = 0;
+        int shift = 2;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i == largest) continue;
+            c[i] = (static_cast<float>(packed >> shift & RotationMax) / RotationMax - 0.5f) * 2 * RotationRange;
+            sum += c[i] * c[i];
+            shift += 15;
+        }
+        c[largest] = std::sqrt(std::max(0.f, 1 - sum));
+        return Quaternion{ c[3], c[0], c[1], c[2] };
+    }
+
+    void writeVarint(std::vector<std::byte>& out, std::uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<std::byte>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<std::byte>(v));
+    }
+
+    void writeDifference(std::vector<std::byte>& out, const std::array<std::int64_t, 3>& current, const std::array<std::int64_t, 3>& previous)
+    {
+        for (int i = 0; i < 3; ++i) writeVarint(out, zigzag(current[i] - previous[i]));
+    }
+
+    //Ascending, as the difference to the previous one
+    void writeIds(std::vector<std::byte>& out, std::span<const std::uint32_t> ids)
+    {
+        writeVarint(out, ids.size());
+        std::uint32_t previous = 0;
+        for (std::uint32_t id : ids)
+        {
+            writeVarint(out, id - previous);
+            previous = id;
+        }
+    }
+
+    class PayloadReader
+    {
+    public:
+        explicit PayloadReader(std::span<const std::byte> data) : _data(data) {}
+
+        std::uint8_t byte()
+        {
+            if (_offset >= _data.size()) throw std::runtime_error("Truncated state stream");
+            return static_cast<std::uint8_t>(_data[_offset++]);
+        }
+
+        std::uint64_t varint()
+        {
+            std::uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                std::uint8_t b = byte();
+                v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            throw std::runtime_error("Invalid state stream");
+        }
+
+        void difference(std::array<std::int64_t, 3>& value)
+        {
+            for (int i = 0; i < 3; ++i) value[i] += unzigzag(varint());
+        }
+
+        void ids(std::vector<std::uint32_t>& out)
+        {
+            out.resize(varint());
+            std::uint32_t previous = 0;
+            for (std::uint32_t& id : out) previous = id = previous + static_cast<std::uint32_t>(varint());
+        }
+
+        std::uint64_t rotation()
+        {
+            std::uint64_t packed = 0;
+            for (std::size_t i = 0; i < RotationBytes; ++i) packed |= static_cast<std::uint64_t>(byte()) << 8 * i;
+            return packed;
+        }
+
+    private:
+        std::span<const std::byte> _data;
+        std::size_t _offset = 0;
+    };
+}
+
+StateStreamWriter::StateStreamWriter(std::ostream& out, StateStreamOptions options)
+    : _out(&out), _options(options)
+{
+    if (_options.keyframe_interval == 0) throw std::runtime_error("The keyframe interval must be at least 1");
+    StreamHeader header{ {}, Version, _options.position_step, _options.scale_step, _options.velocity_step, _options.keyframe_interval };
+    std::memcpy(header.magic, Magic, sizeof(header.magic));
+    _out->write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!*_out) throw std::runtime_error("Unable to write state stream");
+}
+
+void StateStreamWriter::record(const World& world, Seconds time)
+{
+    CGT_PROFILE_ZONE("StateStreamWriter::record");
+    const bool key = _frame % _options.keyframe_interval == 0;
+    _entries.clear();
+    _removed.clear();
+
+    //The moving entities are sorted by owner like the Transformations, the velocity of an entity is found by walking both together
+    std::less<const Entity*> less;
+    auto moving = world.query<Transformation, PhysicsMovement>();
+    auto movement = moving.begin();
+    for (const Transformation& t : world.view<Transformation>())
+    {
+        Entity& e = t.owner();
+        if (!e.active()) continue; //Released to an EntityPool, recorded as removed
+        while (movement != moving.end() && less(&std::get<1>(*movement).owner(), &e)) ++movement;
+        const PhysicsMovement* m = movement != moving.end() && &std::get<1>(*movement).owner() == &e ? &std::get<1>(*movement) : nullptr;
+
+        auto [it, added] = _tracked.try_emplace(&e);
+        Tracked& tracked = it->second;
+        if (!added && tracked.seen == _frame) continue; //Only the first Transformation of an entity is recorded
+        if (!added && !tracked.entity)
+        {
+            //Another entity took the address of a destroyed one
+            if (!key) _removed.push_back(tracked.id);
+            added = true;
+        }
+        if (added) tracked = { e, _next_id++, _frame, {} };
+
+        const bool full = key || added;
+        const impl::QuantizedState previous = full ? impl::QuantizedState{} : tracked.state;
+        impl::QuantizedState current = tracked.state;
+        std::uint8_t mask = 0;
+        if (full || t.changedSince(_since_version))
+        {
+            current.position = quantize(t.worldPosition(), _options.position_step);
+            current.rotation = packRotation(t.worldRotation());
+            current.scale = quantize(t.scale(), _options.scale_step);
+            if (full || current.position != tracked.state.position) mask |= Position;
+            if (full || current.rotation != tracked.state.rotation) mask |= Rotation;
+            if (full || current.scale != tracked.state.scale) mask |= Scale;
+        }
+        if (m)
+        {
+            current.velocity = quantize(m->velocity(), _options.velocity_step);
+            if (full || current.velocity != tracked.state.velocity) mask |= Velocity;
+        }
+
+        if (mask) _entries.push_back({ tracked.id, mask, previous, current });
+        tracked.state = current;
+        tracked.seen = _frame;
+    }
+    for (auto it = _tracked.begin(); it != _tracked.end();)
+    {
+        if (it->second.seen == _frame)
+        {
+            ++it;
+            continue;
+        }
+        if (!key) _removed.push_back(it->second.id);
+        it = _tracked.erase(it);
+    }
+
+    std::sort(_removed.begin(), _removed.end());
+    std::sort(_entries.begin(), _entries.end(), [](const Entry& l, const Entry& r) { return l.id < r.id; });
+
+    _buffer.clear();
+    writeIds(_buffer, _removed);
+    writeVarint(_buffer, _entries.size());
+    std::uint32_t previous_id = 0;
+    for (const Entry& entry : _entries)
+    {
+        writeVarint(_buffer, entry.id - previous_id);
+        previous_id = entry.id;
+    }
+    for (std::size_t i = 0; i < _entries.size(); i += 2)
+    {
+        std::uint8_t high = i + 1 < _entries.size() ? _entries[i + 1].mask : 0;
+        _buffer.push_back(static_cast<std::byte>(_entries[i].mask | high << 4));
+    }
+    for (const Entry& entry : _entries)
+    {
+        if (entry.mask & Position) writeDifference(_buffer, entry.current.position, entry.previous.position);
+        if (entry.mask & Rotation)
+        {
+            for (std::size_t i = 0; i < RotationBytes; ++i) _buffer.push_back(static_cast<std::byte>(entry.current.rotation >> 8 * i));
+        }
+        if (entry.mask & Scale) writeDifference(_buffer, entry.current.scale, entry.previous.scale);
+        if (entry.mask & Velocity) writeDifference(_buffer, entry.current.velocity, entry.previous.velocity);
+    }
+
+    FrameHeader header{ key, static_cast<std::uint32_t>(_buffer.size()), time.count() };
+    _out->write(reinterpret_cast<const char*>(&header), sizeof(header));
+    _out->write(reinterpret_cast<const char*>(_buffer.data()), _buffer.size());
+    _out->flush();
+    if (!*_out) throw std::runtime_error("Unable to write state stream");
+
+    //Changes made between two updates have the version the first one ended with
+    _since_version = world.changeVersion() - 1;
+    ++_frame;
+}
+
+std::size_t StateStreamWriter::frameCount() const
+{
+    return _frame;
+}
+
+Behaviour recordTicks(World& world, StateStreamWriter& writer)
+{
+    Seconds time{};
+    while (true)
+    {
+        co_await nextTick();
+        writer.record(world, time);
+        time += world.tickPeriod();
+    }
+}
+
+StateStreamReplay::StateStreamReplay(World& world, std::istream& in)
+    : _world(&world), _in(&in)
+{
+    StreamHeader header;
+    _in->read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!*_in || std::memcmp(header.magic, Magic, sizeof(header.magic)) != 0 || header.version != Version)
+    {
+        throw std::runtime_error("Not a state stream or unsupported version");
+    }
+    _options = { header.position_step, header.scale_step, header.velocity_step, header.keyframe_interval };
+    _indexed_end = _in->tellg();
+}
+
+bool StateStreamReplay::next()
+{
+    std::streamoff start = _in->tellg();
+    FrameHeader header;
+    _in->read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (*_in)
+    {
+        _buffer.resize(header.size);
+        _in->read(reinterpret_cast<char*>(_buffer.data()), header.size);
+    }
+    if (!*_in)
+    {
+        //Not written yet, or cut short. Read again from the same place next time
+        _in->clear();
+        if (start != -1) _in->seekg(start);
+        return false;
+    }
+
+    if (_frame == _frames.size())
+    {
+        _frames.push_back({ start, header.size, header.key != 0 });
+        if (start != -1) _indexed_end = start + static_cast<std::streamoff>(sizeof(header) + header.size);
+    }
+    _time = Seconds{ header.time };
+    apply(header.key != 0);
+    ++_frame;
+    return true;
+}
+
+void StateStreamReplay::seek(std::size_t frame)
+{
+    CGT_PROFILE_ZONE("StateStreamReplay::seek");
+    if (!indexUpTo(frame)) throw std::runtime_error("Frame not in state stream");
+    std::size_t key = frame;
+    while (!_frames[key].key) --key; //The first frame is always a keyframe
+
+    _in->clear();
+    _in->seekg(_frames[key].offset);
+    for (_frame = key; _frame <= frame;)
+    {
+        if (!next()) throw std::runtime_error("Truncated state stream");
+    }
+}
+
+bool StateStreamReplay::indexUpTo(std::size_t frame)
+{
+    if (frame < _frames.size()) return true;
+    if (_indexed_end == -1) throw std::runtime_error("State stream not seekable");
+
+    std::streamoff resume = _in->tellg();
+    _in->seekg(0, std::ios::end);
+    std::streamoff end = _in->tellg();
+    while (_frames.size() <= frame)
+    {
+        FrameHeader header;
+        if (end - _indexed_end < static_cast<std::streamoff>(sizeof(header))) break;
+        _in->seekg(_indexed_end);
+        _in->read(reinterpret_cast<char*>(&header), sizeof(header));
+        std::streamoff frame_end = _indexed_end + static_cast<std::streamoff>(sizeof(header) + header.size);
+        if (!*_in || frame_end > end) break;
+        _frames.push_back({ _indexed_end, header.size, header.key != 0 });
+        _indexed_end = frame_end;
+    }
+    _in->clear();
+    _in->seekg(resume);
+    return frame < _frames.size();
+}
+
+void StateStreamReplay::apply(bool key)
+{
+    PayloadReader reader(_buffer);
+    reader.ids(_ids);
+    for (std::uint32_t id : _ids)
+    {
+        auto it = _entities.find(id);
+        if (it == _entities.end()) continue;
+        if (Entity* e = it->second.entity.ptr()) e->destroy();
+        _entities.erase(it);
+    }
+
+    reader.ids(_ids);
+    _masks.resize(_ids.size());
+    for (std::size_t i = 0; i < _masks.size(); i += 2)
+    {
+        std::uint8_t packed = reader.byte();
+        _masks[i] = packed & 0xf;
+        if (i + 1 < _masks.size()) _masks[i + 1] = packed >> 4;
+    }
+
+    for (std::size_t i = 0; i < _ids.size(); ++i)
+    {
+        std::uint8_t mask = _masks[i];
+        Replayed& replayed = _entities[_ids[i]];
+        impl::QuantizedState& state = replayed.state;
+        if (key) state = {};
+        if (mask & Position) reader.difference(state.position);
+        if (mask & Rotation) state.rotation = reader.rotation();
+        if (mask & Scale) reader.difference(state.scale);
+        if (mask & Velocity) reader.difference(state.velocity);
+        replayed.seen = _frame;
+
+        glm::vec3 position = dequantize(state.position, _options.position_step);
+        Quaternion rotation = unpackRotation(state.rotation);
+        glm::vec3 scale = dequantize(state.scale, _options.scale_step);
+        Entity* e = replayed.entity.ptr();
+        if (!e)
+        {
+            //New, or destroyed by someone else since, rebuilt with the whole state
+            e = &_world->createEntity();
+            replayed.entity = *e;
+            e->buildComponent<Transformation>(position, rotation, scale);
+            mask &= Velocity;
+        }
+        else if (mask & (Position | Rotation | Scale))
+        {
+            Transformation& t = *e->findComponent<Transformation>();
+            if (mask & Position) t.translation(position);
+            if (mask & Rotation) t.rotation(rotation);
+            if (mask & Scale) t.scale(scale);
+        }
+        if (mask & Velocity) e->getOrBuildComponent<RecordedVelocity>().velocity = dequantize(state.velocity, _options.velocity_step);
+    }
+
+    if (!key) return;
+    for (auto it = _entities.begin(); it != _entities.end();)
+    {
+        if (it->second.seen == _frame)
+        {
+            ++it;
+            continue;
+        }
+        if (Entity* e = it->second.entity.ptr()) e->destroy();
+        it = _entities.erase(it);
+    }
+}
+
+std::size_t StateStreamReplay::frame() const
+{
+    return _frame;
+}
+
+Seconds StateStreamReplay::time() const
+{
+    return _time;
+}
+
+Entity* StateStreamReplay::entity(std::uint32_t id) const
+{
+    auto it = _entities.find(id);
+    return it != _entities.end() ? it->second.entity.ptr() : nullptr;
+}
+
+const StateStreamOptions& StateStreamReplay::options() const
+{
+    return _options;
+}
@@ -0,0 +1,145 @@
+#ifndef CGT_STATESTREAM_H
+#define CGT_STATESTREAM_H
+
+#include "Component.h"
+#include "Transformation.h"
+#include "Behaviour.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <istream>
+#include <ostream>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//Stream of the state of a World, one frame per call to StateStreamWriter::record, for replays and for processes watching
+//a running game through a pipe. A frame only holds the entities whose state changed since the previous one: the world
+//position, world rotation and scale of their Transformation and the velocity of their PhysicsMovement if any. Every
+//keyframe_interval frames a keyframe holds all of them, so that a replay can start from there.
+//Positions, scales and velocities are quantized to a fixed step and stored as variable length differences to their
+//previous value, rotations as their three smallest components on 15 bits. Which of the four changed is a 4 bit mask per entity.
+//Entities are referred to by an id given when first recorded and never reused. The hierarchy of Transformations is not kept.
+
+struct StateStreamOptions
+{
+    float position_step = 1.f / 1024;
+    float scale_step = 1.f / 1024;
+    float velocity_step = 1.f / 256;
+    std::uint32_t keyframe_interval = 64;
+};
+
+namespace impl
+{
+    //State of an entity as last written or read
+    struct QuantizedState
+    {
+        std::array<std::int64_t, 3> position{};
+        std::uint64_t rotation = 0;
+        std::array<std::int64_t, 3> scale{};
+        std::array<std::int64_t, 3> velocity{};
+    };
+}
+
+//Velocity of a replayed entity, built on those recorded with a PhysicsMovement. Replays do not simulate
+class RecordedVelocity : public Component
+{
+public:
+    using Component::Component;
+
+    glm::vec3 velocity{};
+};
+
+class StateStreamWriter
+{
+public:
+    //Writes the header. The stream must outlive the writer
+    explicit StateStreamWriter(std::ostream& out, StateStreamOptions options = {});
+
+    //Writes a frame then flushes the stream, so that a reader at the other end of a pipe gets it at once. Called between
+    //the phases of the World, usually through recordTicks. Time is whatever the replay should show, such as the simulated time
+    void record(const World& world, Seconds time);
+
+    std::size_t frameCount() const;
+private:
+    struct Tracked
+    {
+        WeakRef<Entity> entity; //Invalid once destroyed, even if another entity took its address
+        std::uint32_t id;
+        std::size_t seen; //Last frame the entity was recorded in
+        impl::QuantizedState state;
+    };
+
+    struct Entry
+    {
+        std::uint32_t id;
+        std::uint8_t mask;
+        impl::QuantizedState previous; //Zero for keyframes and new entities
+        impl::QuantizedState current;
+    };
+
+    std::ostream* _out;
+    StateStreamOptions _options;
+    std::unordered_map<const Entity*, Tracked> _tracked;
+    std::uint32_t _next_id = 0;
+    std::size_t _frame = 0;
+    std::uint32_t _since_version = 0; //Transformations changed after it are quantized again
+    std::vector<Entry> _entries; //Reused
+    std::vector<std::uint32_t> _removed; //Reused
+    std::vector<std::byte> _buffer; //Reused, the payload of the frame being written
+};
+
+//Records a frame at the start of every tick, before the tick phase, with the simulated time. A replay then steps like the
+//simulation rather than like the rendering, whose frame rate varies. The writer must outlive the returned Behaviour
+Behaviour recordTicks(World& world, StateStreamWriter& writer);
+
+//Applies the frames of a stream to a World, usually a headless one listing Transformation and RecordedVelocity. Entities
+//are created with a Transformation as they appear in the stream and destroyed as they disappear from it.
+//Frames are indexed as they are read. Seeking needs a seekable stream, replaying a pipe only goes forward
+class StateStreamReplay
+{
+public:
+    //Reads the header. The World and the stream must outlive the replay
+    StateStreamReplay(World& world, std::istream& in);
+
+    //Applies the next frame. False if there is none yet, the stream may be read again once the writer added some
+    bool next();
+    //Shows the state of the frame, replaying from the keyframe at or before it
+    void seek(std::size_t frame);
+
+    std::size_t frame() const; //Index of the frame next applies
+    Seconds time() const; //Of the last frame applied
+    Entity* entity(std::uint32_t id) const; //nullptr if not in the last frame applied
+    const StateStreamOptions& options() const;
+private:
+    struct FrameInfo
+    {
+        std::streamoff offset;
+        std::uint32_t size; //Of the payload
+        bool key;
+    };
+
+    struct Replayed
+    {
+        WeakRef<Entity> entity;
+        std::size_t seen;
+        impl::QuantizedState state;
+    };
+
+    void apply(bool key);
+    bool indexUpTo(std::size_t frame); //False if the stream ends before
+
+    World* _world;
+    std::istream* _in;
+    StateStreamOptions _options;
+    std::vector<FrameInfo> _frames; //Indexed so far
+    std::streamoff _indexed_end = -1; //End of the last indexed frame
+    std::unordered_map<std::uint32_t, Replayed> _entities;
+    std::vector<std::byte> _buffer; //Reused, the payload of the frame being applied
+    std::vector<std::uint32_t> _ids; //Reused
+    std::vector<std::uint8_t> _masks; //Reused
+    std::size_t _frame = 0;
+    Seconds _time{};
+};
+
+#endif
@@ -80,8 +80,8 @@ void Terrain::draw(const glm::mat4& v, const glm::mat4& p) const
     glBindTexture(GL_TEXTURE_2D, _rock);
     glActiveTexture(GL_TEXTURE0+3);
     glBindTexture(GL_TEXTURE_2D, _snow);
-    glm::mat4 m = get<Transformation>().matrix();
-    glm::mat4 inv_mv = get<Transformation>().invMatrix() * inverse(v);
+    glm::mat4 m = get<Transformation>().renderMatrix();
+    glm::mat4 inv_mv = get<Transformation>().renderInvMatrix() * inverse(v);
     glUniformMatrix4fv(0, 1, GL_FALSE, &m[0][0]);
     glUniformMatrix4fv(1, 1, GL_FALSE, &v[0][0]);
     glUniformMatrix4fv(2, 1, GL_FALSE, &p[0][0]);
@@ -118,7 +118,7 @@ void Terrain::drawGeometry(const glm::mat4& v, const glm::mat4& p) const
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, _heightmap);
-    glm::mat4 mvp = p * v * get<Transformation>().matrix();
+    glm::mat4 mvp = p * v * get<Transformation>().renderMatrix();
     glUniformMatrix4fv(0, 1, GL_FALSE, &mvp[0][0]);
     glUniform1f(4, _min_height);
     glUniform1f(5, _max_height);
@@ -1,20 +1,53 @@
 #include "TimedDestroy.h"
 
-void TimedDestroy::update(Seconds delta)
+TimedDestroy::TimedDestroy(const EntityKey& key, const Snapshot& s)
+    : Component(key), _timer(s.timer)
 {
-    _timer -= delta;
-    if (_timer.count() <= 0)
-    {
-        owner().destroy();
-    }
+}
+
+TimedDestroy::Snapshot TimedDestroy::snapshot(const SnapshotWriter&) const
+{
+    return { timer().count() };
+}
+
+void TimedDestroy::start()
+{
+    _started = true;
+    if (owner().active()) _handle = world().schedule(_timer, *this, &TimedDestroy::expire);
+}
+
+void TimedDestroy::stop()
+{
+    world().cancel(_handle);
+    _started = false;
+}
+
+void TimedDestroy::activate()
+{
+    if (_started) _handle = world().schedule(_timer, *this, &TimedDestroy::expire);
+}
+
+void TimedDestroy::deactivate()
+{
+    world().cancel(_handle);
 }
 
 Seconds TimedDestroy::timer() const
 {
-    return _timer;
+    return _started && owner().active() ? world().remaining(_handle) : _timer;
 }
 
 void TimedDestroy::timer(Seconds time)
 {
     _timer = time;
+    if (_started && owner().active())
+    {
+        world().cancel(_handle);
+        _handle = world().schedule(_timer, *this, &TimedDestroy::expire);
+    }
+}
+
+void TimedDestroy::expire()
+{
+    owner().release();
 }
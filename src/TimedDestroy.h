@@ -2,19 +2,38 @@
 #define CGT_TIMEDDESTROY_H
 
 #include "Component.h"
+#include "TimerWheel.h"
 
 
+//Destroys its entity once the timer elapses, through a timer of the World rather than a countdown every update.
+//An entity from an EntityPool is released instead, and its timer starts over when acquired again
 class TimedDestroy : public Component
 {
 public:
+    static constexpr ComponentStorage storage = ComponentStorage::Sparse; //Built and destroyed with every short lived entity
+
+    struct Snapshot
+    {
+        float timer;
+    };
+
     using Component::Component;
+    TimedDestroy(const EntityKey& key, const Snapshot& s);
+    Snapshot snapshot(const SnapshotWriter& writer) const;
 
-    void update(Seconds delta);
+    void start();
+    void stop();
+    void activate();
+    void deactivate();
 
-    Seconds timer() const;
+    Seconds timer() const; //Remaining time
     void timer(Seconds time);
 private:
-    Seconds _timer;
+    void expire();
+
+    Seconds _timer{};
+    TimerHandle _handle; //Scheduled from start
+    bool _started = false;
 };
 
 
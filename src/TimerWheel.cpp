@@ -0,0 +1,179 @@
+#include "TimerWheel.h"
+#include <algorithm>
+#include <cmath>
+
+TimerWheel::TimerWheel(std::pmr::memory_resource* resource)
+    : _nodes(SentinelCount, resource)
+{
+    for (std::uint32_t i = 0; i < SentinelCount; ++i)
+    {
+        _nodes[i].prev = i;
+        _nodes[i].next = i;
+    }
+}
+
+bool TimerWheel::cancel(TimerHandle timer)
+{
+    if (!find(timer)) return false;
+    unlink(timer.index);
+    release(timer.index);
+    return true;
+}
+
+bool TimerWheel::pending(TimerHandle timer) const
+{
+    return find(timer) != nullptr;
+}
+
+Seconds TimerWheel::remaining(TimerHandle timer) const
+{
+    const Node* n = find(timer);
+    if (!n) return Seconds{};
+    return std::chrono::milliseconds(n->expiry - _now) - _remainder;
+}
+
+void TimerWheel::advance(Seconds delta)
+{
+    _remainder += delta;
+    auto elapsed = std::chrono::floor<std::chrono::milliseconds>(_remainder);
+    if (elapsed.count() <= 0) return;
+    _remainder -= elapsed;
+
+    std::uint64_t target = _now + static_cast<std::uint64_t>(elapsed.count());
+    while (_now < target)
+    {
+        if (_size == 0)
+        {
+            _now = target;
+            break;
+        }
+        ++_now;
+        step();
+    }
+}
+
+std::size_t TimerWheel::size() const
+{
+    return _size;
+}
+
+TimerHandle TimerWheel::schedule(Seconds delay, WeakRef<WeakReferencable> target, Callback callback)
+{
+    std::uint32_t node;
+    if (_free != NoNode)
+    {
+        node = _free;
+        _free = _nodes[node].next;
+    }
+    else
+    {
+        node = static_cast<std::uint32_t>(_nodes.size());
+        _nodes.emplace_back();
+    }
+
+    Node& n = _nodes[node];
+    //The current millisecond is already processed, due timers fire at the next one at the earliest
+    auto delay_ms = std::max<std::int64_t>(1, std::llround((delay + _remainder).count() * 1000));
+    n.expiry = _now + static_cast<std::uint64_t>(delay_ms);
+    n.live = true;
+    n.target = std::move(target);
+    n.callback = callback;
+    insert(node);
+    ++_size;
+    return { node, n.generation };
+}
+
+//In the finest level whose range covers the delay, in the slot of the expiry at that level
+void TimerWheel::insert(std::uint32_t node)
+{
+    std::uint64_t expiry = _nodes[node].expiry;
+    std::uint64_t delay = expiry - _now;
+    for (unsigned level = 0; level < Levels; ++level)
+    {
+        if (delay < std::uint64_t{ 1 } << (LevelBits * (level + 1)))
+        {
+            link(node, level * SlotsPerLevel + ((expiry >> (LevelBits * level)) & (SlotsPerLevel - 1)));
+            return;
+        }
+    }
+    //Beyond the last level, waits for the farthest slot then cascades down again
+    std::uint64_t farthest = _now + (std::uint64_t{ 1 } << (LevelBits * Levels)) - 1;
+    link(node, (Levels - 1) * SlotsPerLevel + ((farthest >> (LevelBits * (Levels - 1))) & (SlotsPerLevel - 1)));
+}
+
+void TimerWheel::link(std::uint32_t node, std::uint32_t slot)
+{
+    std::uint32_t last = _nodes[slot].prev;
+    _nodes[node].prev = last;
+    _nodes[node].next = slot;
+    _nodes[last].next = node;
+    _nodes[slot].prev = node;
+}
+
+void TimerWheel::unlink(std::uint32_t node)
+{
+    Node& n = _nodes[node];
+    _nodes[n.prev].next = n.next;
+    _nodes[n.next].prev = n.prev;
+}
+
+void TimerWheel::release(std::uint32_t node)
+{
+    Node& n = _nodes[node];
+    n.live = false;
+    ++n.generation;
+    n.target = nullptr;
+    n.next = _free;
+    _free = node;
+    --_size;
+}
+
+//Moves the timers of the current slot of a level to the finer levels
+void TimerWheel::cascade(unsigned level)
+{
+    std::uint32_t slot = level * SlotsPerLevel + ((_now >> (LevelBits * level)) & (SlotsPerLevel - 1));
+    std::uint32_t node = _nodes[slot].next;
+    _nodes[slot].prev = slot;
+    _nodes[slot].next = slot;
+    while (node != slot)
+    {
+        std::uint32_t next = _nodes[node].next;
+        insert(node);
+        node = next;
+    }
+}
+
+void TimerWheel::step()
+{
+    //Coarser levels first, so that their timers reach level 0 before it fires
+    unsigned level = 1;
+    while (level < Levels && (_now & ((std::uint64_t{ 1 } << (LevelBits * level)) - 1)) == 0) ++level;
+    while (--level > 0) cascade(level);
+
+    //Moved to the firing list so that callbacks cancelling timers of the same slot unlink them from a valid list
+    std::uint32_t slot = _now & (SlotsPerLevel - 1);
+    if (_nodes[slot].next == slot) return;
+    _nodes[FiringSlot].next = _nodes[slot].next;
+    _nodes[FiringSlot].prev = _nodes[slot].prev;
+    _nodes[_nodes[slot].next].prev = FiringSlot;
+    _nodes[_nodes[slot].prev].next = FiringSlot;
+    _nodes[slot].next = slot;
+    _nodes[slot].prev = slot;
+
+    while (_nodes[FiringSlot].next != FiringSlot)
+    {
+        std::uint32_t node = _nodes[FiringSlot].next;
+        unlink(node);
+        WeakRef<WeakReferencable> target = std::move(_nodes[node].target);
+        Callback callback = _nodes[node].callback;
+        release(node);
+        if (WeakReferencable* t = target.ptr()) (t->*callback)();
+    }
+}
+
+const TimerWheel::Node* TimerWheel::find(TimerHandle timer) const
+{
+    if (timer.index < SentinelCount || timer.index >= _nodes.size()) return nullptr;
+    const Node& n = _nodes[timer.index];
+    return n.live && n.generation == timer.generation ? &n : nullptr;
+}
@@ -0,0 +1,81 @@
+#ifndef CGT_TIMERWHEEL_H
+#define CGT_TIMERWHEEL_H
+
+#include "WeakRef.hpp"
+#include <vector>
+#include <memory_resource>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+using Seconds = std::chrono::duration<float>;
+
+struct TimerHandle
+{
+    std::uint32_t index = ~std::uint32_t{};
+    std::uint32_t generation = 0;
+};
+
+//Hierarchical timing wheel with a resolution of a millisecond. Scheduling and cancelling are O(1), advancing costs one slot per
+//elapsed millisecond plus the timers cascading down from the coarser levels. Timers call a member function of their target,
+//unless it is destroyed first, like Event. Timers due at the same millisecond fire in scheduling order
+class TimerWheel
+{
+public:
+    using Callback = void (WeakReferencable::*)();
+
+    explicit TimerWheel(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    template<typename T>
+    TimerHandle schedule(Seconds delay, T& target, void (T::*callback)())
+    {
+        return schedule(delay, WeakRef<WeakReferencable>(target), static_cast<Callback>(callback));
+    }
+
+    //False if the timer already fired or was cancelled
+    bool cancel(TimerHandle timer);
+    bool pending(TimerHandle timer) const;
+    Seconds remaining(TimerHandle timer) const; //Zero once no longer pending
+
+    //Fires the timers due within delta. Callbacks may schedule and cancel timers, the ones they schedule fire in a later millisecond
+    void advance(Seconds delta);
+
+    std::size_t size() const;
+
+private:
+    static constexpr unsigned LevelBits = 6;
+    static constexpr std::uint32_t SlotsPerLevel = 1 << LevelBits;
+    static constexpr unsigned Levels = 4; //Covering about 4.6 hours, longer timers wait in the last level
+    static constexpr std::uint32_t FiringSlot = Levels * SlotsPerLevel;
+    static constexpr std::uint32_t SentinelCount = FiringSlot + 1;
+    static constexpr std::uint32_t NoNode = ~std::uint32_t{};
+
+    //Timers are linked in circular lists, one per slot, starting at the sentinel node of the slot
+    struct Node
+    {
+        std::uint64_t expiry; //In milliseconds
+        std::uint32_t prev;
+        std::uint32_t next;
+        std::uint32_t generation = 0;
+        bool live = false;
+        WeakRef<WeakReferencable> target;
+        Callback callback = nullptr;
+    };
+
+    TimerHandle schedule(Seconds delay, WeakRef<WeakReferencable> target, Callback callback);
+    void insert(std::uint32_t node);
+    void link(std::uint32_t node, std::uint32_t slot);
+    void unlink(std::uint32_t node);
+    void release(std::uint32_t node);
+    void cascade(unsigned level);
+    void step();
+    const Node* find(TimerHandle timer) const;
+
+    std::pmr::vector<Node> _nodes; //Sentinels first
+    std::uint32_t _free = NoNode; //Linked through next
+    std::uint64_t _now = 0; //Milliseconds
+    Seconds _remainder{}; //Below a millisecond, carried to the next advance
+    std::size_t _size = 0;
+};
+
+#endif
@@ -1,19 +1,46 @@
 #include "Transformation.h"
+#include "Snapshot.hpp"
 #include <utility>
 #include <cassert>
 #include <glm/gtc/matrix_transform.hpp>
 
 Transformation::Transformation(const EntityKey& key, Vector translation, Quaternion rotation, Vector scale)
-    : Component(key), _translation(std::move(translation)), _rotation(std::move(rotation)), _scale(std::move(scale))
+    : Component(key), _translation(std::move(translation)), _rotation(std::move(rotation)), _scale(std::move(scale)),
+    _previous_translation(_translation), _previous_rotation(_rotation), _previous_scale(_scale)
 {
 }
 
+Transformation::Transformation(const EntityKey& key, const Snapshot& s)
+    : Transformation(key, s.translation, s.rotation, s.scale)
+{
+}
+
+Transformation::Snapshot Transformation::snapshot(const SnapshotWriter& writer) const
+{
+    return { _translation, _rotation, _scale, _parent ? writer.indexOf(&_parent->owner()) : NoSnapshotEntity };
+}
+
+void Transformation::restoreLinks(const Snapshot& s, const SnapshotReader& reader)
+{
+    if (Entity* e = reader.entity(s.parent))
+    {
+        if (Transformation* p = e->findComponent<Transformation>()) p->addChild(*this);
+    }
+}
+
 void Transformation::stop()
 {
     if (_parent) _parent->removeChild(*this);
     for (auto c : _children) c->parent(nullptr);
 }
 
+void Transformation::beginTick()
+{
+    _previous_translation = _translation;
+    _previous_rotation = _rotation;
+    _previous_scale = _scale;
+}
+
 Vector Transformation::worldPosition() const
 {
     return matrix() * glm::vec4(0, 0, 0, 1);
@@ -27,7 +54,7 @@ Vector Transformation::translation() const
 void Transformation::translation(Vector v)
 {
     _translation = v;
-    markDirty();
+    changed();
 }
 
 Quaternion Transformation::worldRotation() const
@@ -43,7 +70,7 @@ Quaternion Transformation::rotation() const
 void Transformation::rotation(Quaternion v)
 {
     _rotation = normalize(v);
-    markDirty();
+    changed();
 }
 
 Vector Transformation::scale() const
@@ -54,7 +81,7 @@ Vector Transformation::scale() const
 void Transformation::scale(Vector v)
 {
     _scale = v;
-    markDirty();
+    changed();
 }
 
 Matrix Transformation::matrix() const
@@ -79,6 +106,20 @@ Matrix Transformation::invMatrix() const
     return *_inv_matrix;
 }
 
+Matrix Transformation::renderMatrix() const
+{
+    if (!interpolated() && !_parent) return matrix();
+    updateRender();
+    return _render->matrix;
+}
+
+Matrix Transformation::renderInvMatrix() const
+{
+    if (!interpolated() && !_parent) return invMatrix();
+    updateRender();
+    return _render->inv_matrix;
+}
+
 void Transformation::addChild(Transformation& c)
 {
     assert(&c != this);
@@ -107,6 +148,7 @@ void Transformation::parent(Transformation* p)
 {
     _parent = p;
     markDirty();
+    markTreeChanged(world());
 }
 
 void Transformation::parent(Transformation& p)
@@ -114,9 +156,46 @@ void Transformation::parent(Transformation& p)
     parent(&p);
 }
 
+//Changes made outside of a tick happen at once, without interpolation from the previous state
+void Transformation::changed()
+{
+    World& w = world();
+    if (!w.ticking()) beginTick();
+    markDirty();
+    markTreeChanged(w);
+}
+
+void Transformation::markTreeChanged(const World& world)
+{
+    markChanged(world);
+    for (auto& child : _children) child->markTreeChanged(world);
+}
+
+bool Transformation::interpolated() const
+{
+    return _previous_translation != _translation || _previous_rotation != _rotation || _previous_scale != _scale;
+}
+
+//Both matrices from the interpolated translation, rotation and scale, the inverse without a general inversion
+void Transformation::updateRender() const
+{
+    const World& w = world();
+    if (_render && _render->version == w.changeVersion()) return;
+
+    float alpha = w.tickAlpha();
+    Vector translation = mix(_previous_translation, _translation, alpha);
+    Quaternion rotation = slerp(_previous_rotation, _rotation, alpha);
+    Vector scale = mix(_previous_scale, _scale, alpha);
+    Matrix local = glm::scale(translate(glm::mat4(1.0f), translation) * mat4_cast(rotation), scale);
+    Matrix inv_local = translate(glm::scale(glm::mat4(1.0f), 1.f / scale) * mat4_cast(conjugate(rotation)), -translation);
+    if (_parent) _render = Render{ w.changeVersion(), _parent->renderMatrix() * local, inv_local * _parent->renderInvMatrix() };
+    else _render = Render{ w.changeVersion(), local, inv_local };
+}
+
 void Transformation::markDirty()
 {
-    if(_matrix || _inv_matrix) for (auto& child : _children) child->markDirty();
+    if(_matrix || _inv_matrix || _render) for (auto& child : _children) child->markDirty();
     _matrix.reset();
     _inv_matrix.reset();
+    _render.reset();
 }
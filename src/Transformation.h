@@ -7,16 +7,30 @@
 #include <optional>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 using Vector = glm::vec3;
 using Quaternion = glm::quat;
 using Matrix = glm::mat4;
 
-class Transformation : public Component
+//Change tracked, moving a transformation also marks its descendants as changed
+class Transformation : public Component, public ChangeTracked
 {
 public:
+    struct Snapshot
+    {
+        Vector translation;
+        Quaternion rotation;
+        Vector scale;
+        std::uint32_t parent; //Entity index in the snapshot
+    };
+
     Transformation(const EntityKey& key, Vector translation = { 0,0,0 }, Quaternion rotation = { 1, 0, 0, 0 }, Vector scale = { 1,1,1 });
+    Transformation(const EntityKey& key, const Snapshot& s);
+    Snapshot snapshot(const SnapshotWriter& writer) const;
+    void restoreLinks(const Snapshot& s, const SnapshotReader& reader);
     void stop();
+    void beginTick();
 
     Vector worldPosition() const;
     Vector translation() const;
@@ -32,6 +46,11 @@ public:
     Matrix matrix() const;
     Matrix invMatrix() const;
 
+    //Interpolated between the state before the last tick and the current one by World::tickAlpha. Changes made outside
+    //of a tick are not interpolated. Computed once per update, like matrix() until the next change
+    Matrix renderMatrix() const;
+    Matrix renderInvMatrix() const;
+
     void addChild(Transformation& c);
 
     void removeChild(Transformation& c);
@@ -42,16 +61,31 @@ private:
     void parent(Transformation* p);
     void parent(Transformation& p);
     void markDirty();
+    void changed();
+    void markTreeChanged(const World& world);
+    bool interpolated() const;
+    void updateRender() const;
 
     Vector _translation;
     Quaternion _rotation;
     Vector _scale;
+    Vector _previous_translation; //State before the last tick
+    Quaternion _previous_rotation;
+    Vector _previous_scale;
     WeakRef<Transformation> _parent = nullptr;
     std::vector<WeakRef<Transformation>> _children;
 
     //Cached
     mutable std::optional<Matrix> _matrix;
     mutable std::optional<Matrix> _inv_matrix;
+
+    struct Render
+    {
+        std::uint32_t version; //World::changeVersion when computed, which every update moves on
+        Matrix matrix;
+        Matrix inv_matrix;
+    };
+    mutable std::optional<Render> _render;
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "Utility.h"
 #include "SafeGl.h"
+#include "Mesh.h"
 #include <stb_image.h>
 #include <cstring>
 #include <stdexcept>
@@ -3,7 +3,8 @@
 
 #include <iterator>
 #include <filesystem>
-#include "Mesh.h"
+
+struct Image;
 
 namespace Utility
 {
@@ -18,7 +19,9 @@ namespace Utility
         {
             if (!func(*elem_it))
             {
-                *(write_it++) = std::move(*elem_it);
+                //Self move assignment leaves standard containers empty
+                if (write_it != elem_it) *write_it = std::move(*elem_it);
+                ++write_it;
             }
             ++elem_it;
         }
@@ -1,17 +1,158 @@
 #ifndef CGT_WEAKREF_HPP
 #define CGT_WEAKREF_HPP
 
+#include <vector>
+#include <memory_resource>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <cstdint>
+#include <cassert>
+#include <concepts>
+
+class WeakReferencable;
+
+struct Handle
+{
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+
+    friend bool operator==(const Handle& l, const Handle& r) = default;
+};
+
+//Slot table giving each WeakReferencable a generational handle. A handle stays valid until its slot is released,
+//after which the generation no longer matches. Leased by each World from a process wide pool, see HandleTableLease.
+class HandleTable
+{
+public:
+    explicit HandleTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : _slots(resource) {}
+    HandleTable(const HandleTable&) = delete;
+    HandleTable& operator=(const HandleTable&) = delete;
+
+    Handle acquire(const WeakReferencable* ptr)
+    {
+        if (_free == NoSlot)
+        {
+            _slots.push_back({ ptr, 0, NoSlot });
+            return { static_cast<std::uint32_t>(_slots.size() - 1), 0 };
+        }
+
+        std::uint32_t index = _free;
+        Slot& slot = _slots[index];
+        _free = slot.next_free;
+        slot.ptr = ptr;
+        return { index, slot.generation };
+    }
+
+    void release(Handle h) noexcept
+    {
+        Slot& slot = _slots[h.index];
+        slot.ptr = nullptr;
+        ++slot.generation;
+        slot.next_free = _free;
+        _free = h.index;
+    }
+
+    void rebind(Handle h, const WeakReferencable* ptr) noexcept
+    {
+        _slots[h.index].ptr = ptr;
+    }
+
+    //Returns nullptr if the handle is no longer valid
+    const WeakReferencable* resolve(Handle h) const noexcept
+    {
+        const Slot& slot = _slots[h.index];
+        return slot.generation == h.generation ? slot.ptr : nullptr;
+    }
+
+    //Undefined behaviour if the handle is no longer valid
+    const WeakReferencable* uncheckedResolve(Handle h) const noexcept
+    {
+        assert(_slots[h.index].generation == h.generation);
+        return _slots[h.index].ptr;
+    }
+
+private:
+    static constexpr std::uint32_t NoSlot = ~std::uint32_t{};
+
+    struct Slot
+    {
+        const WeakReferencable* ptr;
+        std::uint32_t generation;
+        std::uint32_t next_free;
+    };
+
+    std::pmr::vector<Slot> _slots;
+    std::uint32_t _free = NoSlot;
+};
+
+//Lends a HandleTable to a World. Tables are never freed: a World returns its table to the pool when destroyed, with all
+//of its slots released, and the next World reuses it. Slots only ever grow and generations only ever increase, so a
+//WeakRef that outlives its World still indexes valid memory and reads as null, as long as it is not resolved while a
+//World on another thread is using the table.
+class HandleTableLease
+{
+public:
+    HandleTableLease()
+    {
+        Pool& pool = instance();
+        std::lock_guard lock(pool.mutex);
+        if (pool.free.empty())
+        {
+            pool.tables.push_back(std::make_unique<HandleTable>());
+            _table = pool.tables.back().get();
+        }
+        else
+        {
+            _table = pool.free.back();
+            pool.free.pop_back();
+        }
+    }
+    HandleTableLease(const HandleTableLease&) = delete;
+    HandleTableLease& operator=(const HandleTableLease&) = delete;
+    ~HandleTableLease()
+    {
+        Pool& pool = instance();
+        std::lock_guard lock(pool.mutex);
+        pool.free.push_back(_table);
+    }
+
+    operator HandleTable&() const noexcept { return *_table; }
+
+private:
+    struct Pool
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<HandleTable>> tables;
+        std::vector<HandleTable*> free;
+    };
+
+    //Leaked so that refs held by other statics can still be resolved during static destruction
+    static Pool& instance()
+    {
+        static Pool* pool = new Pool;
+        return *pool;
+    }
+
+    HandleTable* _table;
+};
 
 class WeakReferencable
 {
 protected:
-    WeakReferencable() = default;
-    WeakReferencable(const WeakReferencable&) {}
+    explicit WeakReferencable(HandleTable& table)
+        : _table(&table), _handle(table.acquire(this))
+    {
+    }
+    WeakReferencable(const WeakReferencable& other)
+        : WeakReferencable(*other._table)
+    {
+    }
     WeakReferencable(WeakReferencable&& other) noexcept
-        : _self(std::move(other._self))
+        : _table(other._table), _handle(other._handle)
     {
-        if(_self) *_self = this;
+        other._table = nullptr;
+        if (_table) _table->rebind(_handle, this);
     }
 
     WeakReferencable& operator=(const WeakReferencable& other) = delete;
@@ -19,26 +160,23 @@ protected:
     {
         if (&other == this) return *this;
 
-        if(_self) *_self = nullptr;
-        _self = std::move(other._self);
-        if(_self) *_self = this;
+        if (_table) _table->release(_handle);
+        _table = other._table;
+        _handle = other._handle;
+        other._table = nullptr;
+        if (_table) _table->rebind(_handle, this);
 
         return *this;
     }
 
     ~WeakReferencable() noexcept
     {
-        if(_self) *_self = nullptr;
+        if (_table) _table->release(_handle);
     }
 private:
-    std::shared_ptr<const WeakReferencable*> getSelfPtr() const
-    {
-        if (!_self) _self = std::make_shared<const WeakReferencable*>(this);
-        return _self;
-    }
-
     template<typename T> friend struct WeakRef;
-    mutable std::shared_ptr<const WeakReferencable*> _self;
+    HandleTable* _table; //nullptr once moved from
+    Handle _handle;
 };
 
 
@@ -48,35 +186,44 @@ struct WeakRef
 {
     template<typename U> friend struct WeakRef;
 private:
-    std::shared_ptr<const WeakReferencable*> _ptr;
+    const HandleTable* _table = nullptr;
+    Handle _handle;
     T* uncheckedPtr() const noexcept
     {
-        return const_cast<T*>(static_cast<const T*>(*_ptr));
+        return const_cast<T*>(static_cast<const T*>(_table->uncheckedResolve(_handle)));
     }
 public:
     WeakRef(std::nullptr_t = nullptr) {};
-    WeakRef(T* ptr) : _ptr(ptr? ptr->getSelfPtr() : nullptr) {};
-    WeakRef(T& ref) : _ptr(ref.getSelfPtr()) {}
+    WeakRef(T* ptr)
+    {
+        if (ptr) *this = WeakRef(*ptr);
+    }
+    WeakRef(T& ref) : _table(ref._table), _handle(ref._handle) {}
     WeakRef(const WeakRef& other) = default;
     WeakRef(WeakRef&& other) noexcept
+        : _table(other._table), _handle(other._handle)
     {
-        swap(_ptr, other._ptr);
+        other._table = nullptr;
+        other._handle = {};
     }
     template<typename U>
     WeakRef(const WeakRef<U>& other) requires std::convertible_to<U*, T*>
-        : _ptr(other._ptr)
+        : _table(other._table), _handle(other._handle)
     {
     }
     template<typename U>
     WeakRef(WeakRef<U>&& other) requires std::convertible_to<U*, T*>
+        : _table(other._table), _handle(other._handle)
     {
-        swap(_ptr, other._ptr);
+        other._table = nullptr;
+        other._handle = {};
     }
 
     WeakRef& operator=(const WeakRef& other) = default;
     WeakRef& operator=(WeakRef&& other) noexcept
     {
-        swap(_ptr, other._ptr);
+        std::swap(_table, other._table);
+        std::swap(_handle, other._handle);
 
         return *this;
     }
@@ -84,7 +231,7 @@ public:
     //Returns nullptr if invalid. The other accessors lead to undefined behaviour when invalid
     T* ptr() const noexcept
     {
-        return _ptr? uncheckedPtr() : nullptr;
+        return _table ? const_cast<T*>(static_cast<const T*>(_table->resolve(_handle))) : nullptr;
     }
 
     operator T*() const noexcept
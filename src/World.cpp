@@ -1,93 +1,401 @@
 #include "World.h"
 #include "Entity.h"
 #include "Component.h"
-#include "Light.h"
-#include "Input.h"
-#include "Camera.h"
+#include "Behaviour.hpp"
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+World::~World()
+{
+    //Dependents are registered after their dependencies, so they stop first. Global registries like Physics outlive the world
+    for (auto* list : { &_dynamic_managers, &_static_managers })
+    {
+        for (auto it = list->rbegin(); it != list->rend(); ++it) (*it)->stopAll();
+    }
+    for (QueuedEventBase* e : _queued_events) e->_world = nullptr;
+}
+
+QueuedEventBase::~QueuedEventBase()
+{
+    if (_world) _world->removeQueuedEvent(*this);
+}
 
 Entity& World::createEntity()
 {
-    return *_entities.emplace_back(new Entity(*this));
+    return _entities.create([this](void* storage) { return new (storage) Entity(*this); });
 }
 
 void World::update(Seconds s)
 {
-    Inputs::instance().update();
-
+    CGT_PROFILE_ZONE("World::update");
     _tick_remainder += s;
-    while (_tick_remainder >= _tick_period)
+    for (unsigned ticks = 0; _tick_remainder >= _tick_period && ticks < _max_ticks_per_update; ++ticks)
     {
         tickOnce();
         _tick_remainder -= _tick_period;
     }
+    if (_tick_remainder >= _tick_period)
+    {
+        //Keep the fraction of a period so that the interpolation stays continuous
+        Seconds kept = _tick_remainder - std::floor(_tick_remainder / _tick_period) * _tick_period;
+        _dropped_time += _tick_remainder - kept;
+        _tick_remainder = kept;
+    }
+
+    ++_change_version;
+    auto update = [&s](ComponentManagerBase& m) { m.update(s); };
+    if (_execution_mode == ExecutionMode::Parallel)
+    {
+        runPhase(_update_schedule, &ManagerPhases::update, update);
+    }
+    else
+    {
+        _static_dispatch.update(*this, s);
+        forEachDynamicManager(&ManagerPhases::update, update);
+    }
+
+    {
+        CGT_PROFILE_ZONE("timers");
+        _timers.advance(s);
+    }
+    dispatchQueuedEvents();
+    resumeBehaviours();
+    applyCommands();
+    if (_spatial_reorder_period && ++_updates_since_reorder >= _spatial_reorder_period)
+    {
+        _updates_since_reorder = 0;
+        for (auto& m : _managers)
+        {
+            if (!m || m->_storage != ComponentStorage::Spatial) continue;
+            m->_reorder_requested = true;
+            m->_cleanup_requested = true;
+            _should_cleanup = true;
+        }
+    }
+    cleanup(s);
+    ++_change_version;
+}
+
+void World::tickOnce()
+{
+    CGT_PROFILE_ZONE("World::tickOnce");
+    _ticking = true;
+    ++_change_version;
+    _static_dispatch.begin_tick(*this);
+    forEachDynamicManager(&ManagerPhases::begin_tick, [](ComponentManagerBase& m) { m.beginTick(); });
+
+    if (!_tick_behaviours.empty())
+    {
+        //Behaviours awaiting the next tick again wait for the following one
+        auto behaviours = std::move(_tick_behaviours);
+        _tick_behaviours.clear();
+        for (auto& b : behaviours) if (BehaviourPromise* p = b.ptr()) p->resume();
+    }
+
+    auto tick = [_tick_period = _tick_period](ComponentManagerBase& m) { m.tick(_tick_period); };
+    if (_execution_mode == ExecutionMode::Parallel)
+    {
+        runPhase(_tick_schedule, &ManagerPhases::tick, tick);
+    }
+    else
+    {
+        _static_dispatch.tick(*this, _tick_period);
+        forEachDynamicManager(&ManagerPhases::tick, tick);
+    }
+    _ticking = false;
+}
+
+bool World::cancel(TimerHandle timer)
+{
+    return _timers.cancel(timer);
+}
+
+Seconds World::remaining(TimerHandle timer) const
+{
+    return _timers.remaining(timer);
+}
 
-    forEachManager([&s](ComponentManagerBase& m) { m.update(s); });
+void World::addQueuedEvent(QueuedEventBase& event)
+{
+    if (event._world == this) return;
+    if (event._world) event._world->removeQueuedEvent(event);
+    event._world = this;
+    _queued_events.push_back(&event);
+}
+
+void World::removeQueuedEvent(QueuedEventBase& event)
+{
+    if (event._world != this) return;
+    event._world = nullptr;
+    std::erase(_queued_events, &event);
+}
+
+void World::dispatchQueuedEvents()
+{
+    CGT_PROFILE_ZONE("World::dispatchQueuedEvents");
+    //Listeners may add or remove queued events
+    for (std::size_t i = 0; i < _queued_events.size(); ++i) _queued_events[i]->dispatch();
+}
+
+void World::resumeOnTick(BehaviourPromise& behaviour)
+{
+    _tick_behaviours.emplace_back(behaviour);
+}
+
+bool World::resumeOnDestroy(const Entity& entity, BehaviourPromise& behaviour)
+{
+    if (entity._marked_for_destroy) return false;
+    _destroy_behaviours.emplace(&entity, behaviour);
+    return true;
+}
 
-    while(_should_cleanup)
+void World::readyBehaviour(BehaviourPromise& behaviour)
+{
+    std::scoped_lock lock(_ready_mutex);
+    _ready_behaviours.emplace_back(behaviour);
+}
+
+void World::activate(Entity& e, bool active)
+{
+    e._active = active;
+    for (auto& slot : e._components)
+    {
+        if (Component* c = slot.ref.ptr())
+        {
+            _managers[slot.type]->activate(*c, active);
+            requestCleanup(slot.type); //Which moves the component to or from the dormant part of the storage
+        }
+    }
+}
+
+void World::resumeBehaviours()
+{
+    CGT_PROFILE_ZONE("World::resumeBehaviours");
+    std::pmr::vector<WeakRef<BehaviourPromise>> ready(_resource);
     {
-        _should_cleanup = false;
-        auto it = _entities.begin();
-        forEachManager([&s](ComponentManagerBase& m) { m.cleanup(s); });
+        std::scoped_lock lock(_ready_mutex);
+        ready.swap(_ready_behaviours);
     }
-    erase_if(_entities, [](auto& ptr) { return ptr->_marked_for_destroy; });
+    //Behaviours readied while resuming these wait for the next update
+    for (auto& b : ready) if (BehaviourPromise* p = b.ptr()) p->resume();
 }
 
-extern GLFWwindow* window;
+void ComponentManagerBase::submitCommands(CommandBuffer& commands)
+{
+    _world->submitRecycling(commands);
+}
 
-void World::draw() const
+void World::submit(CommandBuffer buffer)
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    if (Camera* cam = Camera::main())
+    if (buffer.empty()) return;
+    std::scoped_lock lock(_submit_mutex);
+    _submitted.push_back(std::move(buffer));
+}
+
+void World::submitRecycling(CommandBuffer& buffer)
+{
+    if (buffer.empty()) return;
+    std::scoped_lock lock(_submit_mutex);
+    _submitted.push_back(std::move(buffer));
+    if (!_spare_commands.empty())
     {
-        glm::mat4 v = cam->get<Transformation>().invMatrix();
-        glm::mat4 inv_v = cam->get<Transformation>().matrix();
-        glm::mat4 p = cam->projectionMatrix();
+        buffer = std::move(_spare_commands.back());
+        _spare_commands.pop_back();
+    }
+}
 
-        _lights.clear();
-        for (const Light* light : getAll<Light>())
+void World::applyCommands()
+{
+    CGT_PROFILE_ZONE("World::applyCommands");
+    //Buffers may be submitted while applying others, from the constructors of the built components
+    std::pmr::vector<CommandBuffer> applied(_resource);
+    while (true)
+    {
+        std::pmr::vector<CommandBuffer> buffers(_resource);
         {
-            _lights.push_back(light->buildData());
-            _lights.back().pos = v * glm::vec4(_lights.back().pos, 1);
-            _lights.back().vp *= inv_v;
+            std::scoped_lock lock(_submit_mutex);
+            if (_submitted.empty()) break;
+            buffers.swap(_submitted);
         }
+        for (CommandBuffer& b : buffers)
+        {
+            b.apply(*this);
+            applied.push_back(std::move(b));
+        }
+    }
+    //Those not taken back by the next update are freed, so that the spares follow the number of buffers per update
+    std::scoped_lock lock(_submit_mutex);
+    _spare_commands.swap(applied);
+}
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        int w, h;
-        glfwGetWindowSize(window, &w, &h);
-        glViewport(0, 0, w, h);
-        glCullFace(GL_BACK);
+void World::cleanup(Seconds s)
+{
+    CGT_PROFILE_ZONE("World::cleanup");
+    while(_should_cleanup.exchange(false))
+    {
+        _static_dispatch.cleanup(*this, s);
+        forEachDynamicManager(nullptr, [&s](ComponentManagerBase& m) { if (takeCleanupRequest(m)) m.cleanup(s); });
+    }
+    std::pmr::vector<Entity*> destroyed(_resource);
+    {
+        std::scoped_lock lock(_destroyed_mutex);
+        destroyed.swap(_destroyed_entities);
+    }
+    for (Entity* e : destroyed)
+    {
+        if (!_destroy_behaviours.empty())
+        {
+            auto [first, last] = _destroy_behaviours.equal_range(e);
+            {
+                std::scoped_lock lock(_ready_mutex);
+                for (auto it = first; it != last; ++it) _ready_behaviours.push_back(std::move(it->second));
+            }
+            _destroy_behaviours.erase(first, last);
+        }
+        _entities.destroy(*e);
+    }
+}
 
-        for (auto& elem : _managers) elem.second->draw(v, p);
+void World::requestCleanup(ComponentTypeId type, Component* destroyed)
+{
+    if (type >= _managers.size() || !_managers[type]) return; //Not built yet, its manager is flagged by buildComponent
+    ComponentManagerBase& m = *_managers[type];
+    if (destroyed && m._storage != ComponentStorage::OwnerSorted)
+    {
+        std::scoped_lock lock(m._destroyed_mutex);
+        m._destroyed.emplace_back(*destroyed);
     }
+    if (destroyed) m._destroy_requested = true;
+    m._cleanup_requested = true;
+    _should_cleanup = true;
 }
 
-void World::drawGeometry(const glm::mat4& v, const glm::mat4& p) const
+bool World::takeCleanupRequest(ComponentManagerBase& m)
 {
-    for (auto& elem : _managers) elem.second->drawGeometry(v, p);
+    return m._cleanup_requested.exchange(false);
 }
 
-void World::tickOnce()
+std::pmr::memory_resource* World::memoryResource() const
+{
+    return _resource;
+}
+
+ExecutionMode World::executionMode() const
+{
+    return _execution_mode;
+}
+
+void World::executionMode(ExecutionMode mode)
+{
+    _execution_mode = mode;
+}
+
+Seconds World::tickPeriod() const
+{
+    return _tick_period;
+}
+
+void World::tickPeriod(Seconds period)
+{
+    _tick_period = period;
+}
+
+unsigned World::maxTicksPerUpdate() const
+{
+    return _max_ticks_per_update;
+}
+
+void World::maxTicksPerUpdate(unsigned count)
 {
-    forEachManager([_tick_period=_tick_period](ComponentManagerBase& m) { m.tick(_tick_period); });
+    if (count == 0) throw std::invalid_argument("At least one tick per update is needed");
+    _max_ticks_per_update = count;
 }
 
-const std::vector<LightData>& World::lightData() const
+Seconds World::droppedTime() const
+{
+    return _dropped_time;
+}
+
+unsigned World::spatialReorderPeriod() const
+{
+    return _spatial_reorder_period;
+}
+
+void World::spatialReorderPeriod(unsigned updates)
+{
+    _spatial_reorder_period = updates;
+}
+
+std::uint32_t World::changeVersion() const
+{
+    return _change_version;
+}
+
+bool World::ticking() const
+{
+    return _ticking;
+}
+
+float World::tickAlpha() const
+{
+    return _tick_remainder / _tick_period;
+}
+
+void World::rebuildSchedule(Schedule& schedule, bool ManagerPhases::* phase) const
+{
+    schedule.managers.clear();
+    schedule.graph.clear();
+    for (auto* list : { &_static_managers, &_dynamic_managers })
+    {
+        for (ComponentManagerBase* m : *list) if (m->phases().*phase) schedule.managers.push_back(m);
+    }
+
+    //Conflicting managers keep their registration order, so the result matches ExecutionMode::Serial
+    for (std::size_t i = 0; i < schedule.managers.size(); ++i)
+    {
+        schedule.graph.add();
+        for (std::size_t j = 0; j < i; ++j)
+        {
+            if (schedule.managers[i]->access().conflictsWith(schedule.managers[j]->access())) schedule.graph.precede(j, i);
+        }
+    }
+}
+
+template<typename F>
+void World::runPhase(Schedule& schedule, bool ManagerPhases::* phase, F&& func)
+{
+    if (_schedules_dirty)
+    {
+        rebuildSchedule(_update_schedule, &ManagerPhases::update);
+        rebuildSchedule(_tick_schedule, &ManagerPhases::tick);
+        _schedules_dirty = false;
+    }
+
+    WorkerPool::instance().run(schedule.graph, [&](std::size_t i) { func(*schedule.managers[i]); });
+    drainNewManagers(phase, func);
+}
+
+//A null phase runs func on every dynamic manager
+template<typename F>
+void World::forEachDynamicManager(bool ManagerPhases::* phase, F&& func)
 {
-    return _lights;
+    for (ComponentManagerBase* m : _dynamic_managers) if (!phase || m->phases().*phase) func(*m);
+    drainNewManagers(phase, func);
 }
 
+//Managers registered while running a phase still take part in it, after the others
 template<typename F>
-void World::forEachManager(F&& func)
+void World::drainNewManagers(bool ManagerPhases::* phase, F&& func)
 {
-    for (auto& elem : _managers) func(*elem.second);
-    while (!_additional_managers.empty())
+    while (!_new_managers.empty())
     {
-        auto list = std::move(_additional_managers);
-        for (auto& elem : list)
+        _schedules_dirty = true;
+        auto list = std::move(_new_managers);
+        for (ComponentManagerBase* m : list)
         {
-            func(*elem.second);
-            _managers.emplace(std::move(elem));
+            if (!phase || m->phases().*phase) func(*m);
+            _dynamic_managers.push_back(m);
         }
     }
 }
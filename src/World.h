@@ -2,13 +2,28 @@
 #define CGT_WORLD_H
 
 #include <vector>
-#include <unordered_map>
 #include <memory>
 #include <type_traits>
-#include <typeinfo>
-#include <typeindex>
 #include <utility>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <ranges>
+#include <memory_resource>
+#include <iosfwd>
+#include <filesystem>
+#include <unordered_map>
+#include <cstdint>
 #include "ComponentManager.hpp"
+#include "WeakRef.hpp"
+#include "Jobs.h"
+#include "CommandBuffer.h"
+#include "SlabPool.hpp"
+#include "Query.hpp"
+#include "Event.hpp"
+#include "FrameArena.h"
+#include "TimerWheel.h"
 
 struct LightData
 {
@@ -21,37 +36,207 @@ struct LightData
 
 class Entity;
 class Component;
+class SnapshotWriter;
+class SnapshotReader;
+class Prefab;
+class ChangeTracked;
+class BehaviourPromise;
+class EntityPool;
+
+//Compile time list of the component types of a World. Their managers are created upfront, found by a constant time index
+//and their phases are dispatched statically. Types not in the list are still registered dynamically on first build.
+template<typename... Cs>
+struct ComponentList
+{
+};
+
+enum class ExecutionMode
+{
+    Serial, //Managers run one after the other in registration order on the calling thread. Deterministic, meant for debugging
+    Parallel //Managers whose accesses do not conflict run concurrently on the WorkerPool, see ManagerAccess
+};
 
+//The containers of a World, of its managers and of its entities allocate from the memory resource it is given, which must
+//outlive it. The World and its managers themselves, the components' own members, the command buffers and the HandleTable
+//behind WeakRef, which outlives the World, use the global heap.
+//Entities may be destroyed from worker threads during the update phase, so the resource must be thread safe unless the
+//World runs in ExecutionMode::Serial without ParallelComponent types. A monotonic_buffer_resource then frees a whole world at once.
 class World
 {
     friend class Entity;
     friend class Component;
+    friend class Prefab;
+    friend class BehaviourPromise;
+    friend class EntityPool;
+    friend class ComponentManagerBase;
 public:
+    explicit World(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : World(ComponentList<>{}, resource) {}
+
+    template<typename... Cs>
+    explicit World(ComponentList<Cs...>, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _resource(resource),
+        _static_dispatch{
+            []([[maybe_unused]] World& w, [[maybe_unused]] Seconds s) { (w.staticUpdate<Cs>(s), ...); },
+            []([[maybe_unused]] World& w, [[maybe_unused]] Seconds s) { (w.staticTick<Cs>(s), ...); },
+            []([[maybe_unused]] World& w) { (w.staticBeginTick<Cs>(), ...); },
+            []([[maybe_unused]] World& w, [[maybe_unused]] Seconds s) { (w.staticCleanup<Cs>(s), ...); },
+            []([[maybe_unused]] const World& w, [[maybe_unused]] const glm::mat4& v, [[maybe_unused]] const glm::mat4& p) { (w.staticDraw<Cs>(v, p), ...); },
+            []([[maybe_unused]] const World& w, [[maybe_unused]] const glm::mat4& v, [[maybe_unused]] const glm::mat4& p) { (w.staticDrawGeometry<Cs>(v, p), ...); }
+        }
+    {
+        (registerManager<Cs>(false), ...);
+    }
+    ~World();
+
     Entity& createEntity();
     void update(Seconds);
     void draw() const;
     void drawGeometry(const glm::mat4& v, const glm::mat4& p) const;
+    //Allocated from the FrameArena by default, so not to be kept beyond the current update or tick
     template<typename T>
-    auto getAll()
+    auto getAll(std::pmr::memory_resource* resource = FrameArena::resource())
     {
-        return doGetAll<T>();
+        return doGetAll<T>(resource);
     }
 
     template<typename T>
-    auto getAll() const
+    auto getAll(std::pmr::memory_resource* resource = FrameArena::resource()) const
     {
-        return doGetAll<const T>();
+        return doGetAll<const T>(resource);
     }
 
-    const std::vector<LightData>& lightData() const;
+    //Components of a type, sorted by owner unless their storage is Sparse. Invalidated by the next cleanup of their manager
+    template<typename T>
+    std::span<T> view()
+    {
+        return doView<T>();
+    }
+
+    template<typename T>
+    std::span<const T> view() const
+    {
+        return doView<const T>();
+    }
+
+    //ChangeTracked components of a type changed after the given version, in the order of view. Invalidated like view.
+    //Only the blocks of components holding a change since are visited, see ChangeBlocks
+    template<std::derived_from<ChangeTracked> T>
+    auto changed(std::uint32_t since)
+    {
+        return doChanged<T>(since);
+    }
+
+    template<std::derived_from<ChangeTracked> T>
+    auto changed(std::uint32_t since) const
+    {
+        return doChanged<const T>(since);
+    }
+
+    //Entities owning a component of each type, see Query
+    template<typename... Ts>
+    Query<Ts...> query()
+    {
+        static_assert(!(SparseComponent<Ts> || ...), "Query needs the components sorted by owner");
+        return Query<Ts...>(doView<Ts>()...);
+    }
+
+    template<typename... Ts>
+    Query<const Ts...> query() const
+    {
+        static_assert(!(SparseComponent<Ts> || ...), "Query needs the components sorted by owner");
+        return Query<const Ts...>(doView<const Ts>()...);
+    }
+
+    const std::pmr::vector<LightData>& lightData() const;
+
+    //Binary snapshot of the entities and of the components of the listed types, see Snapshot.hpp which defines these.
+    //Components built since the last update and entities released to an EntityPool are not saved. Loading adds the entities to the world.
+    template<typename... Cs>
+    void saveSnapshot(ComponentList<Cs...>, std::ostream& out) const;
+    template<typename... Cs>
+    void saveSnapshot(ComponentList<Cs...> list, const std::filesystem::path& file) const;
+    template<typename... Cs>
+    void loadSnapshot(ComponentList<Cs...>, std::span<const std::byte> data);
+    template<typename... Cs>
+    void loadSnapshot(ComponentList<Cs...> list, const std::filesystem::path& file);
+
+    //Builds count entities from a prefab then calls initializer(entity, index) on each, see Prefab.hpp which defines these.
+    //Room is made upfront for all the entities and for their components in each manager, then the prefab builds one component
+    //type at a time over batches of entities. Like any built component, they join the storage at the next cleanup
+    template<std::invocable<Entity&, std::size_t> F>
+    std::vector<Entity*> instantiate(const Prefab& prefab, std::size_t count, F&& initializer);
+    std::vector<Entity*> instantiate(const Prefab& prefab, std::size_t count);
+    Entity& instantiate(const Prefab& prefab);
+
+    //Calls (target.*callback)() once delay has elapsed, unless the target is destroyed or the timer cancelled first.
+    //Timers fire during update, after the update phase, in the order they are due. Not thread safe, see TimerWheel
+    template<typename T>
+    TimerHandle schedule(Seconds delay, T& target, void (T::*callback)())
+    {
+        return _timers.schedule(delay, target, callback);
+    }
+    bool cancel(TimerHandle timer);
+    Seconds remaining(TimerHandle timer) const; //Zero once fired or cancelled
+
+    //The payloads posted to the event are dispatched at every update, after the update phase and before the submitted
+    //command buffers are applied. An event belongs to a single World, adding it to another one removes it from the first.
+    //Not thread safe. Either the event or the World may be destroyed first
+    void addQueuedEvent(QueuedEventBase& event);
+    void removeQueuedEvent(QueuedEventBase& event);
+
+    //Thread safe. The buffer is applied at the next sync point of update, after the update phase and before the cleanup
+    void submit(CommandBuffer buffer);
+
+    std::pmr::memory_resource* memoryResource() const;
+
+    ExecutionMode executionMode() const;
+    void executionMode(ExecutionMode mode);
+
+    Seconds tickPeriod() const;
+    void tickPeriod(Seconds period);
+
+    //Beyond this many ticks in a single update the simulation falls behind, dropping whole tick periods rather than
+    //spending ever longer catching up. At least 1
+    unsigned maxTicksPerUpdate() const;
+    void maxTicksPerUpdate(unsigned count);
+    Seconds droppedTime() const; //Total simulation time dropped so far
+
+    //Managers with Spatial storage are sorted along a Z-order curve at the cleanup of every this many updates, 0 to never sort them
+    unsigned spatialReorderPeriod() const;
+    void spatialReorderPeriod(unsigned updates);
+
+    //Incremented before every tick, before the update phase and at the end of update. A system remembering the version it
+    //last ran at finds the ChangeTracked components changed since with changed<T>. Changes made during the same phase as the
+    //system share its version and may be missed, such systems should run in a later phase
+    std::uint32_t changeVersion() const;
+
+    bool ticking() const; //True during the tick phase
+    //Fraction of a tick period elapsed since the last tick, in [0, 1). Used to interpolate the rendered state between the last two ticks
+    float tickAlpha() const;
 
 private:
     void tickOnce();
+    void dispatchQueuedEvents();
+    void resumeBehaviours();
+    void applyCommands();
+    void submitRecycling(CommandBuffer& buffer); //Leaves in place of the buffer one applied at the last update, to reuse its arena
+    void cleanup(Seconds s);
+    void requestCleanup(ComponentTypeId type, Component* destroyed = nullptr); //destroyed is the component which shouldDestroy, if any
+    static bool takeCleanupRequest(ComponentManagerBase& m);
+
+    //See Behaviour.hpp
+    void resumeOnTick(BehaviourPromise& behaviour);
+    bool resumeOnDestroy(const Entity& entity, BehaviourPromise& behaviour);
+    void readyBehaviour(BehaviourPromise& behaviour); //Thread safe
+
+    //Sets whether the entity is active and calls the activate or deactivate of its components, see EntityPool
+    void activate(Entity& e, bool active);
+
     template<typename T>
-    std::vector<T*> doGetAll() const
+    std::pmr::vector<T*> doGetAll(std::pmr::memory_resource* resource) const
     {
         using RawT = std::remove_cv_t<T>;
-        std::vector<T*> result;
+        std::pmr::vector<T*> result(resource);
         if (ComponentManager<RawT>* manager = findManager<RawT>())
         {
             auto b = manager->begin();
@@ -62,45 +247,181 @@ private:
         return result;
     }
 
+    template<typename C>
+    void saveSnapshotBlock(std::uint32_t type_index, const SnapshotWriter& writer, std::ostream& out) const;
+    template<typename C>
+    void loadSnapshotBlock(std::uint32_t type_index, std::span<const std::byte> data, std::size_t& offset, const SnapshotReader& reader);
+
+    template<typename T>
+    std::span<T> doView() const
+    {
+        if (ComponentManager<std::remove_cv_t<T>>* manager = findManager<std::remove_cv_t<T>>()) return manager->components();
+        return {};
+    }
+
+    template<typename T>
+    auto doChanged(std::uint32_t since) const
+    {
+        std::span<T> components = doView<T>();
+        std::span<const std::uint32_t> blocks;
+        if (auto* manager = findManager<std::remove_cv_t<T>>()) blocks = manager->changeBlocks();
+        return std::views::iota(std::size_t{ 0 }, blocks.size())
+            | std::views::filter([blocks, since](std::size_t b) { return blocks[b] > since; })
+            | std::views::transform([components](std::size_t b) {
+                std::size_t first = b * ChangeBlocks::BlockSize;
+                return components.subspan(first, std::min(ChangeBlocks::BlockSize, components.size() - first));
+            })
+            | std::views::join
+            | std::views::filter([since](const T& c) { return c.changedSince(since); });
+    }
+
     template<typename T>
     ComponentManager<T>* findManager() const
     {
-        if (auto it = _managers.find(typeid(T)); it != _managers.end())
-        {
-            return static_cast<ComponentManager<T>*>(it->second.get());
-        }
-        else if (auto it = std::find_if(begin(_additional_managers), end(_additional_managers), [](auto& item) { return item.first == typeid(T); }); it != end(_additional_managers))
+        ComponentTypeId id = componentTypeId<T>();
+        return id < _managers.size() ? static_cast<ComponentManager<T>*>(_managers[id].get()) : nullptr;
+    }
+
+    template<typename T>
+    ComponentManager<T>& registerManager(bool dynamic)
+    {
+        ComponentTypeId id = componentTypeId<T>();
+        if (id >= _managers.size()) _managers.resize(id + 1);
+        if (!_managers[id])
         {
-            return static_cast<ComponentManager<T>*>(it->second.get());
+            _managers[id] = std::make_unique<ComponentManager<T>>(_resource);
+            _managers[id]->_world = this;
+            if (dynamic) _new_managers.push_back(_managers[id].get());
+            else _static_managers.push_back(_managers[id].get());
         }
-        return nullptr;
+        return static_cast<ComponentManager<T>&>(*_managers[id]);
     }
 
     template<std::derived_from<Component> T, typename... Args>
     T& buildComponent(Args&&... args)
     {
-        _should_cleanup = true;
-        ComponentManagerBase* manager = findManager<T>();
-        if(!manager)
-        {
-            _additional_managers.emplace_back(typeid(T), std::make_unique<ComponentManager<T>>());
-            manager = _additional_managers.back().second.get();
-        }
+        ComponentManager<T>* manager = findManager<T>();
+        if(!manager) manager = &registerManager<T>(true);
+        requestCleanup(componentTypeId<T>());
+
+        T& c = manager->build(std::forward<Args>(args)...);
+        if constexpr (std::derived_from<T, ChangeTracked>) c._changed_version = _change_version;
+        return c;
+    }
+
+    //Makes room for count components of type T to be built without allocating, see World::instantiate
+    template<std::derived_from<Component> T>
+    void reserveNewComponents(std::size_t count)
+    {
+        ComponentManager<T>* manager = findManager<T>();
+        if (!manager) manager = &registerManager<T>(true);
+        manager->reserveNew(count);
+    }
+
+    //Only valid for the types of the ComponentList given at construction
+    template<typename T>
+    ComponentManager<T>& staticManager() const
+    {
+        return static_cast<ComponentManager<T>&>(*_managers[componentTypeId<T>()]);
+    }
+
+    template<typename T>
+    void staticUpdate(Seconds s)
+    {
+        if constexpr (HasUpdatePhase<T>) staticManager<T>().update(s);
+    }
+
+    template<typename T>
+    void staticTick(Seconds s)
+    {
+        if constexpr (HasTickPhase<T>) staticManager<T>().tick(s);
+    }
+
+    template<typename T>
+    void staticCleanup(Seconds s)
+    {
+        ComponentManager<T>& m = staticManager<T>();
+        if (takeCleanupRequest(m)) m.cleanup(s);
+    }
+
+    template<typename T>
+    void staticBeginTick()
+    {
+        if constexpr (HasBeginTickPhase<T>) staticManager<T>().beginTick();
+    }
 
-        return static_cast<ComponentManager<T>*>(manager)->build(std::forward<Args>(args)...);
+    template<typename T>
+    void staticDraw(const glm::mat4& v, const glm::mat4& p) const
+    {
+        if constexpr (HasDrawPhase<T>) staticManager<T>().draw(v, p);
+    }
+
+    template<typename T>
+    void staticDrawGeometry(const glm::mat4& v, const glm::mat4& p) const
+    {
+        if constexpr (HasDrawGeometryPhase<T>) staticManager<T>().drawGeometry(v, p);
     }
 
+    //Managers of a phase in registration order, and the graph ordering the conflicting ones
+    struct Schedule
+    {
+        std::vector<ComponentManagerBase*> managers;
+        TaskGraph graph;
+    };
+    void rebuildSchedule(Schedule& schedule, bool ManagerPhases::* phase) const;
+
+    //Only used in the cpp, do not need to be defined in the header
+    template<typename F>
+    void runPhase(Schedule& schedule, bool ManagerPhases::* phase, F&& func);
     template<typename F>
-    void forEachManager(F&& func); //Only used in the cpp, does not need to be defined in the header
+    void forEachDynamicManager(bool ManagerPhases::* phase, F&& func);
+    template<typename F>
+    void drainNewManagers(bool ManagerPhases::* phase, F&& func);
+
+    struct StaticDispatch
+    {
+        void (*update)(World&, Seconds);
+        void (*tick)(World&, Seconds);
+        void (*begin_tick)(World&);
+        void (*cleanup)(World&, Seconds);
+        void (*draw)(const World&, const glm::mat4&, const glm::mat4&);
+        void (*draw_geometry)(const World&, const glm::mat4&, const glm::mat4&);
+    };
 
-    std::vector<std::unique_ptr<Entity>> _entities;
-    std::unordered_map<std::type_index, std::unique_ptr<ComponentManagerBase>> _managers;
-    std::vector<std::pair<const std::type_index, std::unique_ptr<ComponentManagerBase>>> _additional_managers; //Needed to prevent rehash in the middle of the update
-    bool _should_cleanup = false;
+    std::pmr::memory_resource* _resource;
+    HandleTableLease _handles; //Declared first so that it outlives every entity and component
+    SlabPool<Entity> _entities{ _resource };
+    std::pmr::vector<std::unique_ptr<ComponentManagerBase>> _managers{ _resource }; //Indexed by ComponentTypeId, null for the types this world does not use
+    StaticDispatch _static_dispatch;
+    std::pmr::vector<ComponentManagerBase*> _static_managers{ _resource }; //From the ComponentList, in order
+    std::pmr::vector<ComponentManagerBase*> _dynamic_managers{ _resource }; //Registered on first build, dispatched through the virtual interface
+    std::pmr::vector<ComponentManagerBase*> _new_managers{ _resource }; //Added to _dynamic_managers outside of the iteration over it
+    ExecutionMode _execution_mode = ExecutionMode::Parallel;
+    Schedule _update_schedule;
+    Schedule _tick_schedule;
+    bool _schedules_dirty = true;
+    std::atomic<bool> _should_cleanup = false; //Set from the update of concurrently running managers, along with the flag of the manager to clean up
+    std::mutex _destroyed_mutex;
+    std::pmr::vector<Entity*> _destroyed_entities{ _resource }; //Freed once their components are cleaned up
+    TimerWheel _timers{ _resource };
+    std::pmr::vector<QueuedEventBase*> _queued_events{ _resource };
+    std::pmr::vector<WeakRef<BehaviourPromise>> _tick_behaviours{ _resource };
+    std::pmr::unordered_multimap<const Entity*, WeakRef<BehaviourPromise>> _destroy_behaviours{ _resource }; //Keyed by the awaited entity
+    std::mutex _ready_mutex;
+    std::pmr::vector<WeakRef<BehaviourPromise>> _ready_behaviours{ _resource }; //Resumed at the next update
+    std::mutex _submit_mutex;
+    std::pmr::vector<CommandBuffer> _submitted{ _resource };
+    std::pmr::vector<CommandBuffer> _spare_commands{ _resource }; //Applied at the last update, empty but keeping their arena
     Seconds _tick_period = std::chrono::milliseconds{ 10 };
     Seconds _tick_remainder{};
+    Seconds _dropped_time{};
+    unsigned _max_ticks_per_update = 5;
+    bool _ticking = false;
+    unsigned _spatial_reorder_period = 64;
+    unsigned _updates_since_reorder = 0;
+    std::uint32_t _change_version = 1; //0 is before any change
 
-    mutable std::vector<LightData> _lights;
+    mutable std::pmr::vector<LightData> _lights{ _resource };
 };
 
 #endif
@@ -0,0 +1,48 @@
+//Rendering part of World, kept apart so that the rest of the World builds without OpenGL
+#include "World.h"
+#include "Entity.h"
+#include "Light.h"
+#include "Camera.h"
+
+extern GLFWwindow* window;
+
+void World::draw() const
+{
+    CGT_PROFILE_ZONE("World::draw");
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (Camera* cam = Camera::main())
+    {
+        glm::mat4 v = cam->get<Transformation>().renderInvMatrix();
+        glm::mat4 inv_v = cam->get<Transformation>().renderMatrix();
+        glm::mat4 p = cam->projectionMatrix();
+
+        _lights.clear();
+        for (const Light& light : view<Light>())
+        {
+            if (!light.owner().active()) continue;
+            _lights.push_back(light.buildData());
+            _lights.back().pos = v * glm::vec4(_lights.back().pos, 1);
+            _lights.back().vp *= inv_v;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        int w, h;
+        glfwGetWindowSize(window, &w, &h);
+        glViewport(0, 0, w, h);
+        glCullFace(GL_BACK);
+
+        _static_dispatch.draw(*this, v, p);
+        for (ComponentManagerBase* m : _dynamic_managers) if (m->phases().draw) m->draw(v, p);
+    }
+}
+
+void World::drawGeometry(const glm::mat4& v, const glm::mat4& p) const
+{
+    _static_dispatch.draw_geometry(*this, v, p);
+    for (ComponentManagerBase* m : _dynamic_managers) if (m->phases().draw_geometry) m->drawGeometry(v, p);
+}
+
+const std::pmr::vector<LightData>& World::lightData() const
+{
+    return _lights;
+}
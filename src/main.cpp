@@ -12,6 +12,7 @@
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <optional>
 
 #include "World.h"
 #include "Mesh.h"
@@ -23,7 +24,12 @@
 #include "Collider.h"
 #include "Camera.h"
 #include "Utility.h"
+#include "Input.h"
+#include "Profiler.h"
 #include "SphereSpawner.h"
+#include "TimedDestroy.h"
+#include "Significance.h"
+#include "StateStream.h"
 
 template<auto D>
 struct RaiiCall
@@ -40,7 +46,7 @@ using namespace Utility;
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 GLFWwindow* window = nullptr;
 
-int main(void)
+int main(int argc, char** argv)
 {
     try {
         if (!glfwInit()) throw std::runtime_error("Glfw initialization failure");
@@ -69,7 +75,8 @@ int main(void)
         MeshData mesh, cube_mesh;
         setUnitSphere(mesh);
         setUnitCube(cube_mesh);
-        World world;
+        //CollisionVolume is listed before PhysicsMovement so that the volumes are registered to the physics first
+        World world{ ComponentList<Transformation, CollisionVolume, PhysicsMovement, Model, Terrain, Light, Camera, SimpleMovement, SphereSpawner, TimedDestroy, Significance, Rotator>{} };
 
         Entity& cube = world.createEntity();
         cube.buildComponent<Model>(loadImage("res/moon.jpg"), cube_mesh);
@@ -99,6 +106,8 @@ int main(void)
         earth_m.addLod(mesh, 1);
         setUnitSphere(mesh, 3, 3);
         earth_m.addLod(mesh, 1); //total 2
+        earth.buildComponent<Rotator>(0.5f);
+        earth.buildComponent<Significance>(2.f, 0.05f); //Spins less often when far or out of view
         //earth.buildComponent<SimpleMovement>().terrain(terrain_comp);
 
         Entity& light = world.createEntity();
@@ -111,6 +120,17 @@ int main(void)
         player.buildComponent<SimpleMovement>();
         player.buildComponent<SphereSpawner>();
 
+        //The state of the world is recorded at every tick to the file given as first argument, if any
+        std::optional<std::ofstream> record_file;
+        std::optional<StateStreamWriter> recorder;
+        Behaviour recording;
+        if (argc > 1)
+        {
+            record_file.emplace(argv[1], std::ios::binary);
+            recorder.emplace(*record_file);
+            recording = recordTicks(world, *recorder);
+        }
+
         auto last_tick = std::chrono::high_resolution_clock::now();
         do
         {
@@ -118,12 +138,16 @@ int main(void)
             std::chrono::duration<float> delta_time = this_tick - last_tick;
             last_tick = this_tick;
 
+            Inputs::instance().update();
             world.update(delta_time);
             world.draw();
 
             glfwSwapBuffers(window);
             glfwPollEvents();
         } while (glfwWindowShouldClose(window) == 0);
+#ifdef CGT_PROFILE
+        Profiler::writeChromeTrace("trace.json"); //Last frames, open in chrome://tracing or Perfetto
+#endif
     }
     catch (std::exception& e)
     {